@@ -0,0 +1,360 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include "tyson.h"
+#include "aio.h"
+#include "fileio.h"
+
+#define load_acquire(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define store_release(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+
+AsyncRing*
+new_async_ring()
+{
+	AsyncRing* ring = (AsyncRing*) calloc(1, sizeof(AsyncRing));
+
+	if (ring)
+		ring->fd = -1;
+	return ring;
+}
+
+
+// Unmaps and closes a live ring, the kernel cancels anything still in flight on it.
+static void
+close_ring(AsyncRing* ring)
+{
+	munmap(ring->sqes, ring->sq_entries * sizeof(struct io_uring_sqe));
+	if (ring->cq_map != ring->sq_map)
+		munmap(ring->cq_map, ring->cq_map_size);
+	munmap(ring->sq_map, ring->sq_map_size);
+	close(ring->fd);
+	ring->fd = -3;
+	ring->inflight = 0;
+}
+
+
+void
+free_async_ring(AsyncRing* ring)
+{
+	if (ring->fd >= 0) {
+		while (ring->inflight) {
+			if (async_wait(ring) < 0)
+				break;
+		}
+		if (ring->fd >= 0)
+			close_ring(ring);
+	}
+	free(ring);
+}
+
+
+/*
+	Setup Ring:
+		Asks the kernel for an io_uring and maps its queues. Raw syscalls
+		are used so there's nothing to link against, failure of any step
+		leaves the ring in synchronous mode for good.
+*/
+static void
+setup_ring(AsyncRing* ring)
+{
+	struct io_uring_params p;
+	u8 *sq, *cq;
+	int fd;
+
+	memset(&p, 0, sizeof(p));
+	fd = (int) syscall(__NR_io_uring_setup, AIO_RING_ENTRIES, &p);
+	if (fd < 0) {
+		ring->fd = -2;
+		return;
+	}
+
+	ring->sq_map_size = p.sq_off.array + (p.sq_entries * sizeof(u32));
+	ring->cq_map_size = p.cq_off.cqes + (p.cq_entries * sizeof(struct io_uring_cqe));
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		if (ring->cq_map_size > ring->sq_map_size)
+			ring->sq_map_size = ring->cq_map_size;
+		ring->cq_map_size = ring->sq_map_size;
+	}
+
+	ring->sq_map = mmap(0, ring->sq_map_size, PROT_READ | PROT_WRITE,
+	                    MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	if (ring->sq_map == MAP_FAILED)
+		goto fail;
+
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		ring->cq_map = ring->sq_map;
+	} else {
+		ring->cq_map = mmap(0, ring->cq_map_size, PROT_READ | PROT_WRITE,
+		                    MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+		if (ring->cq_map == MAP_FAILED) {
+			munmap(ring->sq_map, ring->sq_map_size);
+			goto fail;
+		}
+	}
+
+	ring->sqes = (struct io_uring_sqe*) mmap(0, p.sq_entries * sizeof(struct io_uring_sqe),
+	                                          PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+	                                          fd, IORING_OFF_SQES);
+	if (ring->sqes == MAP_FAILED) {
+		if (ring->cq_map != ring->sq_map)
+			munmap(ring->cq_map, ring->cq_map_size);
+		munmap(ring->sq_map, ring->sq_map_size);
+		goto fail;
+	}
+
+	sq = (u8*) ring->sq_map;
+	cq = (u8*) ring->cq_map;
+	ring->sq_head  = (u32*) (sq + p.sq_off.head);
+	ring->sq_tail  = (u32*) (sq + p.sq_off.tail);
+	ring->sq_mask  = (u32*) (sq + p.sq_off.ring_mask);
+	ring->sq_array = (u32*) (sq + p.sq_off.array);
+	ring->cq_head  = (u32*) (cq + p.cq_off.head);
+	ring->cq_tail  = (u32*) (cq + p.cq_off.tail);
+	ring->cq_mask  = (u32*) (cq + p.cq_off.ring_mask);
+	ring->cqes     = (struct io_uring_cqe*) (cq + p.cq_off.cqes);
+	ring->sq_entries = p.sq_entries;
+	ring->cq_entries = p.cq_entries;
+	ring->fd = fd;
+	return;
+
+fail:
+	close(fd);
+	ring->fd = -2;
+}
+
+
+// Synchronous stand in for when there's no ring.
+static s64
+sync_xfer(u8 op, int fd, u8* buf, u64 n, s64 offset)
+{
+	u64 done = 0;
+	ssize_t got;
+
+	while (done < n) {
+		if (offset < 0 && op == AIO_READ)
+			got = read(fd, buf + done, n - done);
+		else if (offset < 0)
+			got = write(fd, buf + done, n - done);
+		else if (op == AIO_READ)
+			got = pread(fd, buf + done, n - done, (off_t) (offset + done));
+		else
+			got = pwrite(fd, buf + done, n - done, (off_t) (offset + done));
+		if (got > 0)
+			done += (u64) got;
+		else if (got < 0 && errno == EINTR)
+			continue;
+		else if (got < 0 && !done)
+			return -1;
+		else
+			break;
+	}
+
+	return (s64) done;
+}
+
+
+/*
+	Submit:
+		Queues a read into, or write from, buf of n bytes at file offset
+		offset and marks req pending. A negative offset means the file's
+		own position, as pipes and sockets need. The transfer goes
+		straight between the file and buf, there is no staging copy.
+		Requests over AIO_MAX_XFER are cut short and complete with the
+		shorter count.
+
+		Returns 0, or -1 if the op couldn't be submitted, in which case req
+		is left free.
+*/
+s64
+async_submit(AsyncRing* ring, AsyncReq* req, u8 op, int fd, u8* buf, u64 n, s64 offset)
+{
+	struct io_uring_sqe* sqe;
+	u32 tail, idx;
+	int rc;
+
+	if (n > AIO_MAX_XFER)
+		n = AIO_MAX_XFER;
+
+	if (ring->fd == -1)
+		setup_ring(ring);
+
+	if (ring->fd < 0) {
+		req->result = sync_xfer(op, fd, buf, n, offset);
+		req->state = AIO_DONE;
+		return 0;
+	}
+
+	// Keep completions from overflowing their queue.
+	while (ring->inflight >= ring->cq_entries) {
+		if (async_wait(ring) < 0)
+			return -1;
+	}
+
+	tail = *(ring->sq_tail);
+	idx  = tail & *(ring->sq_mask);
+	sqe  = &ring->sqes[idx];
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode    = (op == AIO_READ) ? IORING_OP_READ : IORING_OP_WRITE;
+	sqe->fd        = fd;
+	sqe->addr      = (u64) buf;
+	sqe->len       = (u32) n;
+	sqe->off       = (offset < 0) ? (u64) -1 : (u64) offset;
+	sqe->user_data = (u64) req;
+	ring->sq_array[idx] = idx;
+	store_release(ring->sq_tail, tail + 1);
+
+	req->state = AIO_PENDING;
+	do {
+		rc = (int) syscall(__NR_io_uring_enter, ring->fd, 1, 0, 0, 0, 0);
+	} while (rc < 0 && errno == EINTR);
+
+	if (rc < 1) {
+		// The kernel didn't take the entry, take it back.
+		store_release(ring->sq_tail, tail);
+		req->state = AIO_FREE;
+		return -1;
+	}
+
+	++(ring->inflight);
+	return 0;
+}
+
+
+// Finishes every completed request without blocking, returns how many.
+u64
+async_reap(AsyncRing* ring)
+{
+	struct io_uring_cqe* cqe;
+	AsyncReq* req;
+	u32 head;
+	u64 count = 0;
+
+	if (ring->fd < 0)
+		return 0;
+
+	head = *(ring->cq_head);
+	while (head != load_acquire(ring->cq_tail)) {
+		cqe = &ring->cqes[head & *(ring->cq_mask)];
+		req = (AsyncReq*) cqe->user_data;
+		req->result = (cqe->res < 0) ? -1 : (s64) cqe->res;
+		req->state  = AIO_DONE;
+		++head;
+		++count;
+	}
+	store_release(ring->cq_head, head);
+
+	ring->inflight -= count;
+	return count;
+}
+
+
+/*
+	Wait:
+		Blocks until at least one request completes, if any are in flight.
+		Returns -1 if io_uring_enter fails for good, tearing the ring down
+		first, and on every call to a ring torn down before.
+*/
+int
+async_wait(AsyncRing* ring)
+{
+	int rc;
+
+	if (ring->fd == -3)
+		return -1;
+	if (ring->fd < 0 || !ring->inflight)
+		return 0;
+
+	while (!async_reap(ring)) {
+		rc = (int) syscall(__NR_io_uring_enter, ring->fd, 0, 1, IORING_ENTER_GETEVENTS, 0, 0);
+		if (rc < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+			close_ring(ring);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+
+/*
+	Drain:
+		Waits out every request a context still has in flight, run when a
+		process stops so nothing lands in its image after it's been reset
+		or freed. If the ring can't be waited on any more it's torn down,
+		see AsyncRing, and what's still pending is done with a result of
+		-1.
+*/
+void
+async_drain(VMContext* vm)
+{
+	u64 i;
+
+	for (i=0; i < AIO_SLOTS; ++i) {
+		while (vm->aio[i].state == AIO_PENDING) {
+			if (async_wait(vm->ring) < 0) {
+				async_fail(vm);
+				return;
+			}
+		}
+	}
+}
+
+
+// Ends every request vm has pending as failed.
+void
+async_fail(VMContext* vm)
+{
+	u64 i;
+
+	for (i=0; i < AIO_SLOTS; ++i) {
+		if (vm->aio[i].state == AIO_PENDING) {
+			vm->aio[i].result = -1;
+			vm->aio[i].state  = AIO_DONE;
+		}
+	}
+}
+
+
+/*
+	Start:
+		Takes a free ticket of vm's and submits the request on it, giving
+		the context a ring of its own if it has none. fd is the VM
+		descriptor, its buffer is synced first so the request sees any
+		buffered writes.
+
+		Returns the ticket, or -1 if there's no free ticket, no such file
+		or the submit failed.
+*/
+s64
+async_start(VMContext* vm, u8 op, s64 fd, u8* buf, u64 n, s64 offset)
+{
+	s64 ticket;
+	int osfd;
+
+	for (ticket=0; ticket < AIO_SLOTS; ++ticket) {
+		if (vm->aio[ticket].state == AIO_FREE)
+			break;
+	}
+	if (ticket == AIO_SLOTS)
+		return -1;
+
+	osfd = file_fd(vm->pro->files, fd);
+	if (osfd < 0)
+		return -1;
+
+	if (!vm->ring) {
+		vm->ring = new_async_ring();
+		if (!vm->ring)
+			return -1;
+		vm->own_ring = TRUE;
+	}
+
+	if (async_submit(vm->ring, &vm->aio[ticket], op, osfd, buf, n, offset) < 0)
+		return -1;
+	return ticket;
+}
@@ -0,0 +1,57 @@
+#ifndef aio_h
+#define aio_h
+
+#include "tyson.h"
+
+// Submission queue entries asked of the kernel, completions get twice as many.
+#define AIO_RING_ENTRIES  (256)
+
+// Largest single transfer, io_uring lengths are 32 bit.
+#define AIO_MAX_XFER      (1 << 30)
+
+// Request ops.
+#define AIO_READ   0
+#define AIO_WRITE  1
+
+/*
+	Async Ring:
+		One io_uring shared by every context a worker thread runs, so that
+		a thread with all of its processes parked can sleep on a single
+		ring until any of their requests complete. The ring is only set up
+		on first use, and if the kernel won't give us one requests are done
+		synchronously at submit instead, which keeps the instructions
+		usable everywhere, just not asynchronous.
+
+		Each completion's user_data is the AsyncReq it belongs to, so a
+		request is finished by whichever context happens to reap it.
+
+		A ring that can't be waited on, io_uring_enter failing for good,
+		is torn down there and then: closing it has the kernel cancel
+		whatever it still holds, so no late completion can land in an
+		image or name a reused request. It's never set up again, later
+		waits fail so each context gives up its own pending requests,
+		and later requests are done synchronously.
+*/
+struct AsyncRing {
+	int  fd;       // -1 before setup, -2 when io_uring is unavailable, -3 once torn down.
+	u64  inflight;
+	u32  sq_entries;
+	u32  cq_entries;
+	u32  *sq_head, *sq_tail, *sq_mask, *sq_array;
+	u32  *cq_head, *cq_tail, *cq_mask;
+	void *sq_map, *cq_map;
+	u64  sq_map_size, cq_map_size;
+	struct io_uring_sqe* sqes;
+	struct io_uring_cqe* cqes;
+};
+
+AsyncRing* new_async_ring();
+void       free_async_ring(AsyncRing*);
+s64        async_submit(AsyncRing*, AsyncReq*, u8, int, u8*, u64, s64);
+u64        async_reap(AsyncRing*);
+int        async_wait(AsyncRing*);
+void       async_drain(VMContext*);
+void       async_fail(VMContext*);
+s64        async_start(VMContext*, u8, s64, u8*, u64, s64);
+
+#endif
@@ -0,0 +1,426 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <fcntl.h>
+
+#include "tyson.h"
+#include "batch.h"
+#include "aio.h"
+#include "fileio.h"
+
+typedef struct {
+	char**  lines;
+	size_t* caps;
+	u64*    results;
+	int*    status; // what run_context gave each run.
+	u64     count;
+	u64     next;
+} BatchBlock;
+
+typedef struct {
+	Batch*      bat;
+	BatchBlock* blk;
+	u64         id;
+} BatchJob;
+
+
+/*
+	Make Args:
+		Builds the args image for one run the same way ty_main does, the
+		image path is arg 0 followed by each whitespace separated word of
+		the line. Words that would overflow ARGS_BUFFER_SIZE are dropped.
+*/
+static void
+make_args(ProcessArgs* pargs, const char* path, const char* line)
+{
+	u64 len = strlen(path) + 1;
+
+	memcpy(pargs->buf, path, len);
+	pargs->argc  = 1;
+	pargs->argsz = len;
+
+	for (;;) {
+		while (isspace((u8) *line))
+			++line;
+		if (!*line)
+			break;
+		len = strcspn(line, " \t\r\n\v\f");
+		if ((pargs->argsz + len + 1) > ARGS_BUFFER_SIZE) {
+			fprintf(stderr, "\n\targs too long, truncated: %s", line);
+			break;
+		}
+		memcpy((pargs->buf + pargs->argsz), line, len);
+		pargs->buf[pargs->argsz + len] = 0;
+		pargs->argsz += len + 1;
+		++(pargs->argc);
+		line += len;
+	}
+}
+
+
+Batch*
+build_batch(const char* path, u64 workers)
+{
+	Batch* bat;
+	TextImage* timg = read_text_image(path);
+	Process* pro;
+	u64 i;
+
+	if (!timg)
+		return 0;
+
+	bat = (Batch*) calloc(1, sizeof(Batch));
+	if (!bat) {
+		free_text_image(timg);
+		return 0;
+	}
+	bat->timg    = timg;
+	bat->path    = path;
+	bat->workers = workers ? workers : 1;
+	bat->vms     = (VMContext**) calloc(bat->workers * BATCH_SLOTS, sizeof(VMContext*));
+	bat->pargs   = (ProcessArgs*) calloc(bat->workers * BATCH_SLOTS, sizeof(ProcessArgs));
+	bat->rings   = (AsyncRing**) calloc(bat->workers, sizeof(AsyncRing*));
+	bat->usage   = (VMUsage*) calloc(bat->workers, sizeof(VMUsage));
+
+	// Everything is zeroed first, so free_batch can take back whatever got built.
+	if (!bat->vms || !bat->pargs || !bat->rings || !bat->usage) {
+		free_batch(bat);
+		return 0;
+	}
+
+	for (i=0; i < bat->workers; ++i) {
+		bat->rings[i] = new_async_ring();
+		if (!bat->rings[i]) {
+			free_batch(bat);
+			return 0;
+		}
+	}
+
+	for (i=0; i < (bat->workers * BATCH_SLOTS); ++i) {
+		bat->pargs[i].buf = (u8*) malloc(ARGS_BUFFER_SIZE);
+		if (!bat->pargs[i].buf) {
+			free_batch(bat);
+			return 0;
+		}
+		make_args(&bat->pargs[i], path, "");
+		pro = spawn_process(timg, &bat->pargs[i]);
+		bat->vms[i] = pro ? new_context(pro) : 0;
+		if (!bat->vms[i]) {
+			if (pro)
+				free_process(pro);
+			free_batch(bat);
+			return 0;
+		}
+		bat->vms[i]->owner = bat->vms[i]->pro;
+		bat->vms[i]->pro->debug = FALSE;
+		bat->vms[i]->ring = bat->rings[i / BATCH_SLOTS];
+		bat->vms[i]->parkable = TRUE;
+	}
+
+	return bat;
+}
+
+
+void
+free_batch(Batch* bat)
+{
+	u64 i;
+
+	for (i=0; i < (bat->workers * BATCH_SLOTS); ++i) {
+		if (bat->vms && bat->vms[i])
+			free_context(bat->vms[i]);
+		if (bat->pargs)
+			free(bat->pargs[i].buf);
+	}
+	for (i=0; i < bat->workers; ++i) {
+		if (bat->rings && bat->rings[i])
+			free_async_ring(bat->rings[i]);
+	}
+	free(bat->vms);
+	free(bat->pargs);
+	free(bat->rings);
+	free(bat->usage);
+	free_text_image(bat->timg);
+	free(bat);
+}
+
+
+// Raises each of most's figures to run's where run's is the greater.
+static void
+usage_max(VMUsage* most, const VMUsage* run)
+{
+	const uint64_t* r = (const uint64_t*) run;
+	uint64_t* m = (uint64_t*) most;
+	u64 i;
+
+	for (i=0; i < (sizeof(VMUsage) / sizeof(uint64_t)); ++i) {
+		if (r[i] > m[i])
+			m[i] = r[i];
+	}
+}
+
+
+/*
+	Batch Worker:
+		Keeps each of the worker's slots busy with the next unrun line,
+		running them in turn. A slot whose process parks is passed over
+		until its turn comes round again, and if a whole pass finishes no
+		run the worker waits on its ring for some request to complete.
+*/
+static void*
+batch_worker(void* arg)
+{
+	BatchJob*    job   = (BatchJob*) arg;
+	VMContext**  vms   = job->bat->vms + (job->id * BATCH_SLOTS);
+	ProcessArgs* pargs = job->bat->pargs + (job->id * BATCH_SLOTS);
+	AsyncRing*   ring  = job->bat->rings[job->id];
+	VMUsage*     most  = job->bat->usage + job->id;
+	VMUsage      used;
+	int rv;
+	u64 line[BATCH_SLOTS];
+	u64 live = 0, done, i, s;
+	u8  more = TRUE;
+
+	for (s=0; s < BATCH_SLOTS; ++s)
+		line[s] = job->blk->count;
+
+	for (;;) {
+		for (s=0; more && s < BATCH_SLOTS; ++s) {
+			if (line[s] != job->blk->count)
+				continue;
+			i = __atomic_fetch_add(&job->blk->next, 1, __ATOMIC_RELAXED);
+			if (i >= job->blk->count) {
+				more = FALSE;
+				break;
+			}
+			make_args(&pargs[s], job->bat->path, job->blk->lines[i]);
+			reset_process(vms[s]->pro, job->bat->timg, &pargs[s]);
+			bind_context(vms[s], vms[s]->pro);
+			line[s] = i;
+			++live;
+		}
+		if (!live)
+			break;
+
+		for (s=0, done=0; s < BATCH_SLOTS; ++s) {
+			if (line[s] == job->blk->count)
+				continue;
+			rv = run_context(vms[s], EXEC_RUN);
+			if (rv == VM_PARKED)
+				continue;
+			job->blk->results[line[s]] = vms[s]->pro->result;
+			job->blk->status[line[s]]  = rv;
+			ty_usage(vms[s], &used);
+			usage_max(most, &used);
+			line[s] = job->blk->count;
+			--live;
+			++done;
+		}
+		// A dead ring fails whatever is parked on it, so each AWAIT sees -1.
+		if (!done && async_wait(ring) < 0) {
+			for (s=0; s < BATCH_SLOTS; ++s)
+				async_fail(vms[s]);
+		}
+	}
+
+	return 0;
+}
+
+
+/*
+	Run Batch:
+		Reads one argument set per line from in, running them a block of
+		BATCH_BLOCK_SIZE at a time across the batch's workers. Workers take
+		the next unrun line as they come free, so the results of each block
+		are buffered and written to out in input order, one per line, each
+		being the word on top of the stack when that run died, or !error
+		for a run that failed rather than dying. Failed runs are counted
+		in the batch's failed.
+
+		Returns the number of runs made.
+*/
+u64
+run_batch(Batch* bat, FILE* in, FILE* out)
+{
+	BatchBlock blk;
+	BatchJob*  jobs    = (BatchJob*) malloc(bat->workers * sizeof(BatchJob));
+	pthread_t* threads = (pthread_t*) malloc(bat->workers * sizeof(pthread_t));
+	u8*        spawned = (u8*) malloc(bat->workers);
+	u64 total = 0, workers, i;
+
+	blk.lines   = (char**) calloc(BATCH_BLOCK_SIZE, sizeof(char*));
+	blk.caps    = (size_t*) calloc(BATCH_BLOCK_SIZE, sizeof(size_t));
+	blk.results = (u64*) malloc(BATCH_BLOCK_SIZE * sizeof(u64));
+	blk.status  = (int*) malloc(BATCH_BLOCK_SIZE * sizeof(int));
+	// Nothing can be run without these, which counts as a failure.
+	if (!jobs || !threads || !spawned || !blk.lines || !blk.caps || !blk.results || !blk.status) {
+		++bat->failed;
+		goto done;
+	}
+
+	for (;;) {
+		for (blk.count=0; blk.count < BATCH_BLOCK_SIZE; ++blk.count) {
+			if (getline(&blk.lines[blk.count], &blk.caps[blk.count], in) < 0)
+				break;
+		}
+		if (!blk.count)
+			break;
+
+		blk.next = 0;
+		workers = (bat->workers < blk.count) ? bat->workers : blk.count;
+		for (i=0; i < workers; ++i) {
+			jobs[i].bat = bat;
+			jobs[i].blk = &blk;
+			jobs[i].id  = i;
+		}
+
+		// Worker 0 runs on this thread.
+		for (i=1; i < workers; ++i)
+			spawned[i] = (pthread_create(&threads[i], 0, batch_worker, &jobs[i]) == 0);
+		batch_worker(&jobs[0]);
+		for (i=1; i < workers; ++i) {
+			if (spawned[i])
+				pthread_join(threads[i], 0);
+		}
+
+		for (i=0; i < blk.count; ++i) {
+			if (blk.status[i] == VM_ERROR) {
+				fprintf(out, "!error\n");
+				++bat->failed;
+			} else {
+				fprintf(out, "%llu\n", (unsigned long long) blk.results[i]);
+			}
+		}
+
+		total += blk.count;
+		if (blk.count < BATCH_BLOCK_SIZE)
+			break;
+	}
+
+done:
+	for (i=0; blk.lines && i < BATCH_BLOCK_SIZE; ++i)
+		free(blk.lines[i]);
+	free(blk.lines);
+	free(blk.caps);
+	free(blk.results);
+	free(blk.status);
+	free(jobs);
+	free(threads);
+	free(spawned);
+
+	return total;
+}
+
+
+// The most any run so far has used, across every worker.
+void
+batch_usage(Batch* bat, VMUsage* usage)
+{
+	u64 i;
+
+	memset(usage, 0, sizeof(VMUsage));
+	for (i=0; i < bat->workers; ++i)
+		usage_max(usage, &bat->usage[i]);
+}
+
+
+/*
+	Batch Main:
+		tyson -b [-u] [-o outfile] <image.tpx> [argfile]
+
+		Runs the image once per line of argfile, or of stdin if it's
+		missing or "-", with one worker per online cpu. Results go to
+		stdout, a timing summary to stderr followed by the most any one
+		run used of the stacks and heap. The stack peak is a lower bound
+		unless -u runs every context on the depth table, see Usage.
+		What the processes show or write to their fd 1 goes to stderr,
+		or outfile with -o, so stdout holds nothing but results.
+
+		Exits 1 if any run failed.
+*/
+int
+batch_main(int argc, char* argv[])
+{
+	Batch* bat;
+	FILE*  in = stdin;
+	long   cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	struct timespec t0, t1;
+	double usecs;
+	u64    runs;
+	VMUsage most;
+	u8     depth = FALSE;
+	int    out = 2, failed;
+	u64    i;
+
+	// Past the flags the args are where they'd be without them.
+	while (argc > 2) {
+		if (strcmp(argv[2], "-u") == 0) {
+			depth = TRUE;
+			--argc;
+			++argv;
+		} else if (strcmp(argv[2], "-o") == 0 && argc > 3) {
+			out = open(argv[3], O_WRONLY | O_CREAT | O_TRUNC, 0666);
+			if (out < 0) {
+				fprintf(stderr, "\n\tfailed to open \"%s\".\n", argv[3]);
+				return 1;
+			}
+			argc -= 2;
+			argv += 2;
+		} else {
+			break;
+		}
+	}
+
+	if (argc < 3 || argc > 4) {
+		fprintf(stderr, "\n\tusage: tyson -b [-u] [-o outfile] <image.tpx> [argfile]\n");
+		return 1;
+	}
+
+	if (argc == 4 && strcmp(argv[3], "-") != 0) {
+		in = fopen(argv[3], "r");
+		if (!in) {
+			fprintf(stderr, "\n\tfailed to open \"%s\".\n", argv[3]);
+			return 1;
+		}
+	}
+
+	bat = build_batch(argv[2], (cpus > 0) ? (u64) cpus : 1);
+	if (!bat) {
+		fprintf(stderr, "\n\tfailed to open \"%s\".\n", argv[2]);
+		if (in != stdin)
+			fclose(in);
+		return 1;
+	}
+
+	for (i=0; i < (bat->workers * BATCH_SLOTS); ++i) {
+		ty_track_depth(bat->vms[i], depth);
+		ty_output_fd(bat->vms[i], out);
+		file_redirect(bat->vms[i]->pro->files, 1, out);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	runs = run_batch(bat, in, stdout);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	fflush(stdout);
+
+	usecs = ((t1.tv_sec - t0.tv_sec) * 1e6) + ((t1.tv_nsec - t0.tv_nsec) / 1e3);
+	fprintf(stderr, "\tbatch: %llu runs on %llu workers in %.0f us (%.2f us/run)\n",
+	        (unsigned long long) runs, (unsigned long long) bat->workers,
+	        usecs, runs ? (usecs / runs) : 0.0);
+	if (bat->failed)
+		fprintf(stderr, "\tbatch: %llu runs failed\n", (unsigned long long) bat->failed);
+	batch_usage(bat, &most);
+	print_usage(stderr, &most);
+
+	failed = (bat->failed != 0);
+	if (in != stdin)
+		fclose(in);
+	free_batch(bat);
+	if (out != 2)
+		close(out);
+	return failed;
+}
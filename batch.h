@@ -0,0 +1,42 @@
+#ifndef batch_h
+#define batch_h
+
+#include "tyson.h"
+
+// Arg sets read and run per round, results are written out in order after each.
+#define BATCH_BLOCK_SIZE  (4096)
+
+// Processes each worker keeps going at once, so one parked on i/o doesn't idle it.
+#define BATCH_SLOTS       (4)
+
+/*
+	Batch:
+		One text image run over many argument sets. Each worker owns
+		BATCH_SLOTS contexts, each bound to a process spawned from the text
+		image and with its own ProcessArgs buffer, all reused from run to
+		run, so a run costs a process reset and nothing more. A worker's
+		contexts share one async ring, when a process parks on AWAIT the
+		worker runs its other slots, sleeping on the ring only when every
+		one of them is parked. SHOW output and anything a process writes
+		to its fd 1 go to stderr, or wherever the host sends them, never
+		to the results. Each worker also keeps the most any of its runs
+		used of the stacks and heap, for sizing deployments by.
+*/
+typedef struct {
+	TextImage*   timg;
+	const char*  path;
+	VMContext**  vms;
+	ProcessArgs* pargs;
+	AsyncRing**  rings;
+	VMUsage*     usage; // per worker.
+	u64          workers;
+	u64          failed; // runs that ended in VM_ERROR.
+} Batch;
+
+Batch* build_batch(const char*, u64);
+u64    run_batch(Batch*, FILE*, FILE*);
+void   free_batch(Batch*);
+void   batch_usage(Batch*, VMUsage*);
+int    batch_main(int, char*[]);
+
+#endif
@@ -0,0 +1,249 @@
+import os
+import sys
+import json
+import time
+import tempfile
+import subprocess
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from tyson import opmap
+
+# bench/opcost.py [-t tyson] [-n iterations] [-r repeats] [-o costs.json]
+#   generates a program per opcode, each running a snippet that uses it UNROLL times over
+#   in an LSTART/LTEST loop, and times them against the empty loop to get the steady-state
+#   cost of every opcode that can run in isolation, then of some common pairs. -o writes
+#   the per-opcode ns as a cost model, {"ns": {opcode: ns}, "below_resolution": [opcode]},
+#   where an opcode that costs nothing measurable once its snippet's other parts are taken
+#   away is given 0 and listed as below resolution rather than a negative cost. tyson must
+#   be a REAL_MODE build, see bench/run.py.
+
+BENCH_DIR = os.path.dirname(os.path.abspath(__file__))
+ROOT_DIR  = os.path.dirname(BENCH_DIR)
+TYASM     = os.path.join(ROOT_DIR, 'tyasm.py')
+UNROLL    = 16
+
+# heap words the snippets scribble on, strings they read and the table tdx walks.
+SCRATCH = 8192
+STR_A   = 9000
+STR_B   = 9100
+STR_C   = 9200
+TABLE   = 16384
+
+init = ['put_s {} < "the quick brown fox jumps over the lazy dog" >'.format(STR_A),
+        'put_s {} < "the quick brown fox jumps over the lazy cat" >'.format(STR_B),
+        'put_s {} < "lazy" >'.format(STR_C)]
+
+pop = 'stk_pop {}'.format(SCRATCH)
+
+def binary(op, a='3', b='7'):
+	return ['stk_psh0', 'stk_pshc ' + a, 'stk_pshc ' + b, op, pop]
+
+def unary(op, a='3'):
+	return ['stk_pshc ' + a, op, pop]
+
+def jump(op, a, b):
+	return ['stk_pshc ' + a, 'stk_pshc ' + b, op + ' {next}', '{next}:', pop, pop]
+
+def pushes(op):
+	return [op, pop]
+
+# (name, opcode, snippet): the snippet runs UNROLL times a loop and must leave the stack as
+# it found it. Every opcode in it but the named one must be costed by an entry before it,
+# the first entry's two being split evenly as no snippet can tell them apart.
+recipes = [('stk_psh0',     'stk_psh0',     ['stk_psh0', pop]),
+           ('stk_pshc',     'stk_pshc',     ['stk_pshc 3', pop]),
+           ('stk_psh1',     'stk_psh1',     pushes('stk_psh1')),
+           ('stk_psh2',     'stk_psh2',     pushes('stk_psh2')),
+           ('stk_psh',      'stk_psh',      pushes('stk_psh {}'.format(SCRATCH))),
+           ('stk_spoffs',   'stk_spoffs',   pushes('stk_spoffs')),
+           ('stk_top_dup',  'stk_top_dup',  ['stk_psh0', 'stk_top_dup', pop, pop]),
+           ('stk_top_dup2', 'stk_top_dup2', ['stk_psh0', 'stk_top_dup2', pop, pop, pop]),
+           ('stk_xcht',     'stk_xcht',     ['stk_psh0', 'stk_psh1', 'stk_xcht', pop, pop]),
+           ('stk_xch',      'stk_xch',      ['stk_psh0', 'stk_psh1', 'stk_xch 0 8', pop, pop]),
+           ('stk_cpy',      'stk_cpy',      ['stk_psh0', 'stk_psh1', 'stk_cpy 0 8', pop, pop]),
+           ('stk_setc',     'stk_setc',     ['stk_psh0', 'stk_setc 0 5', pop]),
+           ('stk_set',      'stk_set',      ['stk_psh0', 'stk_set 0 {}'.format(SCRATCH), pop]),
+           ('stk_ovwr',     'stk_ovwr',     ['stk_psh0', 'stk_ovwr {}'.format(SCRATCH), pop]),
+           ('stk_stor',     'stk_stor',     ['stk_psh0', 'stk_stor {}'.format(SCRATCH), pop]),
+           ('stk_tapsh',    'stk_tapsh',    ['stk_pshc {}'.format(SCRATCH), 'stk_tapsh', pop]),
+           ('put_w',        'put_w',        ['put_w {} 5'.format(SCRATCH)]),
+           ('cpy_b',        'cpy_b',        ['cpy_b {} {}'.format(SCRATCH, SCRATCH + 8)]),
+           ('cpy_w',        'cpy_w',        ['cpy_w {} {}'.format(SCRATCH, SCRATCH + 8)]),
+           ('xch_b',        'xch_b',        ['xch_b {} {}'.format(SCRATCH, SCRATCH + 8)]),
+           ('xch_w',        'xch_w',        ['xch_w {} {}'.format(SCRATCH, SCRATCH + 8)]),
+           ('cpy_s',        'cpy_s',        ['cpy_s {} {}'.format(SCRATCH, STR_A)]),
+           ('str_len',      'str_len',      pushes('str_len {}'.format(STR_A))),
+           ('str_cmp',      'str_cmp',      pushes('str_cmp {} {}'.format(STR_A, STR_B))),
+           ('str_chr',      'str_chr',      pushes('str_chr {} 122'.format(STR_A))),
+           ('str_cspn',     'str_cspn',     pushes('str_cspn {} {}'.format(STR_A, STR_C))),
+           ('str_str',      'str_str',      pushes('str_str {} {}'.format(STR_A, STR_C))),
+           ('set_tdx_fc',   'set_tdx_fc',   ['set_tdx_fc {}'.format(TABLE)]),
+           ('tdx_w_up',     'tdx_w_up',     ['set_tdx_fc {}'.format(TABLE), 'tdx_w_up']),
+           ('t_fd_putw',    't_fd_putw',    ['set_tdx_fc {}'.format(TABLE), 't_fd_putw 5']),
+           ('set_c1',       'set_c1',       ['set_c1 {}'.format(TABLE)]),
+           ('jmp',          'jmp',          ['jmp {next}', '{next}:']),
+           ('jmp_c1',       'jmp_c1',       ['set_c1 {next}', 'jmp_c1', '{next}:']),
+           ('swch',         'swch',         ['stk_psh0', 'swch {next}', '{next}:']),
+           ('call+ret',     'call',         ['call leaf'])]
+
+for t in ('b', 'u', 'i'):
+	for op in ('add', 'sub', 'mul', 'div', 'mod', 'inc', 'dec'):
+		name = '{}_{}'.format(op, t)
+		recipes.append((name, name, unary(name) if op in ('inc', 'dec') else binary(name)))
+for op in ('add_r', 'sub_r', 'mul_r', 'div_r'):
+	recipes.append((op, op, binary(op, '2.5', '1.5')))
+for op in ('and', 'or', 'xor', 'lsh', 'rsh'):
+	recipes.append((op, op, binary(op, '3', '5')))
+recipes.append(('not', 'not', ['stk_psh0', 'stk_pshc 1', 'not', pop]))
+for op in ('eq', 'neq'):
+	recipes.append((op, op, ['stk_pshc 3', 'stk_pshc 3', op, pop, pop, pop]))
+for a in ('b', 'u', 'i', 'r'):
+	for b in ('b', 'u', 'i', 'r'):
+		if a != b:
+			name = '{}2{}'.format(a, b)
+			recipes.append((name, name, unary(name)))
+for t in ('u', 'i', 'r'):
+	for op in ('jgeq', 'jleq', 'jgt', 'jlt'):
+		name = '{}_{}'.format(op, t)
+		low, high = ('1.5', '2.5') if t == 'r' else ('3', '5')
+		fall, taken = ((high, low), (low, high)) if op in ('jgeq', 'jgt') else ((low, high), (high, low))
+		recipes.append((name, name, jump(name, *fall)))
+		recipes.append((name + ' taken', name, jump(name, *taken)))
+for name in ('jeq_w', 'jneq_w'):
+	recipes.append((name, name, jump(name, '3', '5')))
+
+# idioms a superinstruction might replace, measured whole against the sum of their parts.
+pairs = [('stk_psh inc_u stk_pop',   ['stk_psh {}'.format(SCRATCH), 'inc_u', 'stk_pop {}'.format(SCRATCH)]),
+         ('stk_pshc add_u',          ['stk_psh0', 'stk_psh1', 'stk_pshc 7', 'add_u', pop]),
+         ('stk_top_dup dec_u',       ['stk_psh1', 'stk_top_dup', 'dec_u', pop, pop]),
+         ('stk_pshc jlt_u',          ['stk_psh1', 'stk_pshc 5', 'jlt_u {next}', '{next}:', pop, pop]),
+         ('stk_psh stk_tapsh',       ['stk_psh {}'.format(SCRATCH + 8), 'stk_tapsh', pop])]
+
+def program(snippet, iterations):
+	lines = ['heap 65536', 'start:'] + init
+	lines.append('lstart {} body done'.format(iterations))
+	lines.append('body:')
+	for k in range(UNROLL):
+		for instr in snippet:
+			lines.append(instr.replace('{next}', 'n{}'.format(k)))
+	lines += ['ltest', 'done:', 'stk_spoffs', 'show_top_u', 'die', 'leaf:', 'ret']
+	return '\n'.join(lines) + '\n'
+
+# best wall time of repeats, and the stack offset the run ended on.
+def measure(tyson, snippet, iterations, repeats, scratch):
+	src = os.path.join(scratch, 'op.tys')
+	img = os.path.join(scratch, 'op.tpx')
+	open(src, 'w').write(program(snippet, iterations))
+	subprocess.run([sys.executable, TYASM, src, img, '1'], cwd=ROOT_DIR, check=True, stdout=subprocess.DEVNULL)
+	best = None
+	for _ in range(repeats):
+		start = time.perf_counter()
+		run = subprocess.run([tyson, img], stdin=subprocess.DEVNULL, capture_output=True, text=True)
+		elapsed = time.perf_counter() - start
+		best = elapsed if best is None else min(best, elapsed)
+	return best, run.stdout.split()[-1] if run.stdout.split() else None
+
+def cpu_ghz():
+	try:
+		for line in open('/proc/cpuinfo'):
+			if line.startswith('cpu MHz'):
+				return float(line.split(':')[1]) / 1000.0
+	except (OSError, ValueError):
+		pass
+	return None
+
+def opname(instr):
+	return instr.split()[0] if not instr.endswith(':') else None
+
+def main(args):
+	tyson, iterations, repeats, out = os.path.join(ROOT_DIR, 'tyson'), 200000, 3, None
+	i = 0
+	while i + 1 < len(args):
+		if args[i] == '-t':
+			tyson = args[i + 1]
+		elif args[i] == '-n':
+			iterations = int(args[i + 1])
+		elif args[i] == '-r':
+			repeats = int(args[i + 1])
+		elif args[i] == '-o':
+			out = args[i + 1]
+		else:
+			break
+		i += 2
+	if i != len(args):
+		print('\n\tinvalid input to bench/opcost.py.')
+		return 2
+
+	ghz = cpu_ghz()
+	runs = iterations * UNROLL
+	cost = {}
+	rows = []
+	with tempfile.TemporaryDirectory() as scratch:
+		empty, depth = measure(tyson, [], iterations, repeats, scratch)
+
+		def snippet_ns(snippet):
+			seconds, end = measure(tyson, snippet, iterations, repeats, scratch)
+			if end != depth:
+				raise RuntimeError('snippet {} moves the stack'.format(snippet))
+			return (seconds - empty) * 1e9 / runs
+
+		for name, target, snippet in recipes:
+			ops = [opname(instr) for instr in snippet if opname(instr)]
+			unknown = sorted(set(op for op in ops if op != target and op not in cost))
+			if cost and unknown:
+				print('\n\t{} not costed, not costing {}.'.format(' '.join(unknown), name))
+				continue
+			try:
+				ns = snippet_ns(snippet)
+			except RuntimeError as err:
+				print('\n\t{}, not costing {}.'.format(err, name))
+				continue
+			if not cost:
+				cost['stk_psh0'] = cost['stk_pop'] = max(ns / 2, 0.0)
+				rows.append(('stk_psh0', ns / 2))
+				rows.append(('stk_pop', ns / 2))
+				continue
+			others = sum(cost[op] for op in ops if op != target)
+			ns = (ns - others) / ops.count(target)
+			if ' ' not in name:
+				cost[name] = max(ns, 0.0)
+			rows.append((name, ns))
+
+		pair_rows = []
+		for name, snippet in pairs:
+			ops = [opname(instr) for instr in snippet if opname(instr)]
+			unknown = sorted(set(op for op in ops if op not in cost))
+			if unknown:
+				print('\n\t{} not costed, not timing {}.'.format(' '.join(unknown), name))
+				continue
+			ns = snippet_ns(snippet)
+			parts = sum(cost[op] for op in ops)
+			pair_rows.append((name, ns, parts))
+
+	costed = set(name for name in cost if name in opmap)
+	if 'call+ret' in cost:
+		costed |= set(['call', 'ret'])
+	print('\n\t{} of {} opcodes costed, {} runs of each snippet.\n'.format(len(costed), len(opmap), runs))
+	print('\t{:<16} {:>8} {:>8}'.format('opcode', 'ns', 'cycles' if ghz else ''))
+	for name, ns in sorted(rows, key=lambda row: -row[1]):
+		if ns <= 0:
+			print('\t{:<16} {:>8} {:>8}  below resolution, {:.3f} raw'.format(name, '0', '', ns))
+		else:
+			print('\t{:<16} {:>8.3f} {:>8}'.format(name, ns, '{:.1f}'.format(ns * ghz) if ghz else ''))
+
+	print('\n\t{:<24} {:>8} {:>8} {:>8}'.format('sequence', 'ns', 'parts', 'diff'))
+	for name, ns, parts in pair_rows:
+		print('\t{:<24} {:>8.3f} {:>8.3f} {:>+8.3f}'.format(name, ns, parts, ns - parts))
+
+	missing = sorted(name for name in opmap if name not in costed)
+	print('\n\tnot costed, control flow, i/o or state the loop can\'t repeat:\n\t\t{}'.format(' '.join(missing)))
+
+	if out:
+		model = {'ns': {name: max(ns, 0.0) for name, ns in rows},
+		         'below_resolution': sorted(name for name, ns in rows if ns <= 0)}
+		with open(out, 'w') as f:
+			json.dump(model, f, indent=1, sort_keys=True)
+	return 0
+
+if __name__ == '__main__':
+	sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,140 @@
+import os
+import sys
+import json
+import time
+import tempfile
+import platform
+import subprocess
+
+# bench/run.py [-t tyson]... [-r repeats] [-b baseline.json] [-s save.json] [-x threshold%] [bench...]
+#   assembles the bench programs with tyasm.py and times each under every engine variant,
+#   reporting ns per VM instruction and millions of instructions a second.
+#
+#   -t names a tyson binary built in REAL_MODE, more than one compares builds:
+#       gcc -O2 -DREAL_MODE -pthread $(ls *.c | grep -v tyasm_wrap) -o tyson -lm
+#   -b compares against a baseline -s saved earlier and exits 1 on any variant slower by
+#   more than the threshold, 10% unless -x says otherwise. Timings only compare on the
+#   machine they came from, which -s records under "machine": bench/baseline.json is the
+#   one the tree keeps, re-save it with -s when measuring on another.
+
+BENCH_DIR = os.path.dirname(os.path.abspath(__file__))
+ROOT_DIR  = os.path.dirname(BENCH_DIR)
+TYASM     = os.path.join(ROOT_DIR, 'tyasm.py')
+
+benches = {'arith'     : 'mul_u and add_u on a heap word, the basic arithmetic loop',
+           'scan'      : 'eight passes summing a 1M word table through stk_tapsh',
+           'strings'   : 'str_len, str_chr, str_str, cpy_s and str_cmp on an 80 byte string',
+           'recursion' : 'naive fib(34), call and ret heavy',
+           'swch'      : 'swch over eight cases picked by an lcg, unpredictable dispatch',
+           'shuffle'   : 'stk_xcht, stk_xch, stk_top_dup and stk_cpy on a four word stack'}
+
+# dispatch tables a context can run on, by the flags that put it there.
+def variants(scratch):
+	return [('plain',  []),
+	        ('prof',   ['-p']),
+	        ('cycles', ['-P']),
+	        ('sample', ['-s', os.path.join(scratch, 'samples')]),
+	        ('trace',  ['-t', os.path.join(scratch, 'trace')])]
+
+def assemble(name, scratch):
+	out = os.path.join(scratch, name + '.tpx')
+	subprocess.run([sys.executable, TYASM, os.path.join(BENCH_DIR, name + '.tys'), out, '1'],
+	               cwd=ROOT_DIR, check=True, stdout=subprocess.DEVNULL)
+	return out
+
+# what a run executes, from the total the profiler puts at the top of its table.
+def count_instructions(tyson, image):
+	run = subprocess.run([tyson, '-p', image], stdin=subprocess.DEVNULL, capture_output=True, text=True)
+	for line in run.stderr.splitlines():
+		words = line.split()
+		if len(words) >= 3 and words[0] == 'profile:':
+			return int(words[1])
+	raise RuntimeError('no profile from {} {}'.format(tyson, image))
+
+# the cpu's model name, to tell baselines from different machines apart.
+def machine():
+	try:
+		for line in open('/proc/cpuinfo'):
+			if line.startswith('model name'):
+				return line.split(':', 1)[1].strip()
+	except OSError:
+		pass
+	return platform.machine()
+
+# best of repeats, the least disturbed.
+def time_run(tyson, flags, image, repeats):
+	best = None
+	for _ in range(repeats):
+		start = time.perf_counter()
+		subprocess.run([tyson] + flags + ['-o', os.devnull, image], stdin=subprocess.DEVNULL,
+		               stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL, check=True)
+		elapsed = time.perf_counter() - start
+		best = elapsed if best is None else min(best, elapsed)
+	return best
+
+def main(args):
+	tysons, repeats, baseline, save, threshold, names = [], 5, None, None, 10.0, []
+	i = 0
+	while i < len(args):
+		if args[i] in ('-t', '-r', '-b', '-s', '-x') and i + 1 < len(args):
+			flag, value = args[i], args[i + 1]
+			if flag == '-t':
+				tysons.append(value)
+			elif flag == '-r':
+				repeats = int(value)
+			elif flag == '-b':
+				baseline = json.load(open(value))
+			elif flag == '-s':
+				save = value
+			else:
+				threshold = float(value)
+			i += 2
+		elif args[i] in benches:
+			names.append(args[i])
+			i += 1
+		else:
+			print('\n\tinvalid input to bench/run.py.')
+			return 2
+	if not tysons:
+		tysons = [os.path.join(ROOT_DIR, 'tyson')]
+	names = names or list(benches)
+
+	results = {'machine': machine()}
+	regressions = []
+	if baseline and baseline.get('machine') != results['machine']:
+		print('\n\tbaseline is from {}, not this machine.'.format(baseline.get('machine', 'an unknown machine')))
+	with tempfile.TemporaryDirectory() as scratch:
+		print('\n\t{:<10} {:<14} {:<8} {:>12} {:>9} {:>10} {:>9}'.format('bench', 'tyson', 'variant',
+		      'instrs', 'ns/instr', 'Minstr/s', 'vs base'))
+		for name in names:
+			image = assemble(name, scratch)
+			for tyson in tysons:
+				count = count_instructions(tyson, image)
+				for variant, flags in variants(scratch):
+					seconds = time_run(tyson, flags, image, repeats)
+					ns = seconds * 1e9 / count
+					key = '{}/{}/{}'.format(name, os.path.basename(tyson), variant)
+					results[key] = ns
+
+					change = ''
+					if baseline and key in baseline:
+						delta = 100.0 * (ns - baseline[key]) / baseline[key]
+						change = '{:+.1f}%'.format(delta)
+						if delta > threshold:
+							regressions.append((key, delta))
+					print('\t{:<10} {:<14} {:<8} {:>12} {:>9.3f} {:>10.1f} {:>9}'.format(name,
+					      os.path.basename(tyson), variant, count, ns, count / seconds / 1e6, change))
+
+	if save:
+		with open(save, 'w') as f:
+			json.dump(results, f, indent=1, sort_keys=True)
+
+	if regressions:
+		print('\n\tslower than the baseline by more than {}%:'.format(threshold))
+		for key, delta in regressions:
+			print('\t\t{} {:+.1f}%'.format(key, delta))
+		return 1
+	return 0
+
+if __name__ == '__main__':
+	sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,102 @@
+/*
+	String Kernel Benchmark:
+		Times every string kernel set this cpu runs against the scalar
+		baseline over haystacks of a few sizes, checking each agrees with
+		scalar as it goes.
+
+		gcc -O2 -I.. strk_bench.c ../strk.c ../cpu.c -o strk_bench
+		./strk_bench [iterations]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tyson.h"
+#include "cpu.h"
+#include "strk.h"
+
+#define MAX_LEN  (1 << 20)
+
+static u8 hay[MAX_LEN + 64];
+static u64 sink;
+
+
+static double
+now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static void
+fill(u64 len)
+{
+	u64 i;
+
+	srand(1);
+	for (i=0; i < len; ++i)
+		hay[i] = 'a' + (rand() % 20);
+	hay[len] = 0;
+	memcpy(hay + len - 6, "xyzzyq", 6);
+}
+
+
+static int
+bench(const StrKernels* k, u64 len, u64 iters)
+{
+	const u8* reject = (const u8*) "xyz";
+	const u8* needle = (const u8*) "xyzzy";
+	double t0, t1, t2, t3;
+	u64 i;
+
+	if (k->chr(hay, 'x') != strk_scalar.chr(hay, 'x') ||
+	    k->cspn(hay, reject) != strk_scalar.cspn(hay, reject) ||
+	    k->str(hay, needle) != strk_scalar.str(hay, needle)) {
+		printf("%-8s disagrees with scalar at length %lu\n", k->name, len);
+		return 1;
+	}
+
+	t0 = now();
+	for (i=0; i < iters; ++i)
+		sink += k->chr(hay, 'x');
+	t1 = now();
+	for (i=0; i < iters; ++i)
+		sink += k->cspn(hay, reject);
+	t2 = now();
+	for (i=0; i < iters; ++i)
+		sink += k->str(hay, needle);
+	t3 = now();
+
+	printf("%-8s %8lu  chr %7.2f  cspn %7.2f  str %7.2f  GB/s\n", k->name, len,
+	       len * iters / (t1 - t0) / 1e9,
+	       len * iters / (t2 - t1) / 1e9,
+	       len * iters / (t3 - t2) / 1e9);
+	return 0;
+}
+
+
+int
+main(int argc, char* argv[])
+{
+	u64 lens[] = {16, 256, 4096, 65536, MAX_LEN};
+	u64 features = cpu_features();
+	u64 iters = (argc > 1) ? strtoull(argv[1], NULL, 10) : 1 << 24;
+	u64 i;
+	int bad = 0;
+
+	printf("selected: %s\n", str_kernels()->name);
+	for (i=0; i < sizeof(lens) / sizeof(lens[0]); ++i) {
+		fill(lens[i]);
+		bad |= bench(&strk_scalar, lens[i], iters / lens[i] + 1);
+		#if defined(__x86_64__)
+		if (features & CPU_SSE2)
+			bad |= bench(&strk_sse2, lens[i], iters / lens[i] + 1);
+		if (features & CPU_AVX2)
+			bad |= bench(&strk_avx2, lens[i], iters / lens[i] + 1);
+		#endif
+	}
+	return bad;
+}
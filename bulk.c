@@ -0,0 +1,123 @@
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <emmintrin.h>
+#endif
+
+#include "tyson.h"
+#include "bulk.h"
+
+// Words bulk_diff hands to memcmp at a time before looking closer.
+#define DIFF_CHUNK  (64)
+
+
+#if defined(__x86_64__)
+
+/*
+	Stream Copy:
+		Stores run 16 bytes aligned, so dst is brought to a 16 byte
+		boundary with an ordinary copy first, the rest streamed and
+		whatever's left under 16 bytes copied normally. The fence orders
+		the streamed stores before anything written after.
+*/
+static void
+stream_copy(u8* dst, const u8* src, u64 bytes)
+{
+	u64 head = (16 - ((u64) dst & 15)) & 15;
+	u64 i;
+
+	memcpy(dst, src, head);
+	dst   += head;
+	src   += head;
+	bytes -= head;
+
+	for (i=0; i + 64 <= bytes; i += 64) {
+		_mm_stream_si128((__m128i*) (dst + i),      _mm_loadu_si128((const __m128i*) (src + i)));
+		_mm_stream_si128((__m128i*) (dst + i + 16), _mm_loadu_si128((const __m128i*) (src + i + 16)));
+		_mm_stream_si128((__m128i*) (dst + i + 32), _mm_loadu_si128((const __m128i*) (src + i + 32)));
+		_mm_stream_si128((__m128i*) (dst + i + 48), _mm_loadu_si128((const __m128i*) (src + i + 48)));
+	}
+	_mm_sfence();
+	memcpy(dst + i, src + i, bytes - i);
+}
+
+
+static void
+stream_fill(u8* dst, u64 value, u64 n)
+{
+	__m128i v = _mm_set1_epi64x(value);
+	u64 i = 0;
+
+	// Words are 8 byte aligned at best, one store brings it to 16.
+	if ((u64) dst & 15) {
+		memcpy(dst, &value, wordsize);
+		dst += wordsize;
+		--n;
+	}
+	for (; i + 8 <= n; i += 8) {
+		_mm_stream_si128((__m128i*) (dst + i * wordsize),      v);
+		_mm_stream_si128((__m128i*) (dst + i * wordsize + 16), v);
+		_mm_stream_si128((__m128i*) (dst + i * wordsize + 32), v);
+		_mm_stream_si128((__m128i*) (dst + i * wordsize + 48), v);
+	}
+	_mm_sfence();
+	for (; i < n; ++i)
+		memcpy(dst + i * wordsize, &value, wordsize);
+}
+
+#endif
+
+
+void
+bulk_copy(u8* dst, const u8* src, u64 n)
+{
+	u64 bytes = n * wordsize;
+
+	#if defined(__x86_64__)
+	if (bytes >= BULK_STREAM_SIZE && (dst + bytes <= src || src + bytes <= dst)) {
+		stream_copy(dst, src, bytes);
+		return;
+	}
+	#endif
+	memmove(dst, src, bytes);
+}
+
+
+void
+bulk_fill(u8* dst, u64 value, u64 n)
+{
+	u64 i;
+
+	#if defined(__x86_64__)
+	if (n * wordsize >= BULK_STREAM_SIZE && !((u64) dst & 7)) {
+		stream_fill(dst, value, n);
+		return;
+	}
+	#endif
+
+	// Byte-repeating values are memset's, and zero is most fills.
+	if (value == (value & 0xff) * 0x0101010101010101) {
+		memset(dst, (int) (value & 0xff), n * wordsize);
+		return;
+	}
+	for (i=0; i < n; ++i)
+		memcpy(dst + i * wordsize, &value, wordsize);
+}
+
+
+u64
+bulk_diff(const u8* a, const u8* b, u64 n)
+{
+	u64 i = 0, end;
+
+	while (i < n) {
+		end = (n - i < DIFF_CHUNK) ? n : i + DIFF_CHUNK;
+		if (memcmp(a + i * wordsize, b + i * wordsize, (end - i) * wordsize)) {
+			for (; i < end; ++i)
+				if (memcmp(a + i * wordsize, b + i * wordsize, wordsize))
+					return i;
+		}
+		i = end;
+	}
+	return n;
+}
@@ -0,0 +1,27 @@
+#ifndef bulk_h
+#define bulk_h
+
+#include "tyson.h"
+
+// Copies and fills at least this many bytes bypass the cache.
+#define BULK_STREAM_SIZE  ((u64) 1 << 22)
+
+/*
+	Bulk:
+		Word at a time table work for the runtime-count T_* instructions,
+		counts in words throughout.
+
+		bulk_copy   memmove n words from src to dst.
+		bulk_fill   store n copies of a word.
+		bulk_diff   index of the first word a and b differ in, n if none.
+
+		Copies and fills past BULK_STREAM_SIZE are bigger than the cache
+		can usefully hold, so on x86-64 they use non-temporal stores that
+		go straight to memory instead of evicting everything else on the
+		way. A copy whose ends overlap always takes memmove.
+*/
+void bulk_copy(u8* dst, const u8* src, u64 n);
+void bulk_fill(u8* dst, u64 value, u64 n);
+u64  bulk_diff(const u8* a, const u8* b, u64 n);
+
+#endif
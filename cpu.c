@@ -0,0 +1,25 @@
+#include "tyson.h"
+#include "cpu.h"
+
+
+u64
+cpu_features()
+{
+	u64 features = 0;
+
+	#if defined(__x86_64__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse2"))
+		features |= CPU_SSE2;
+	if (__builtin_cpu_supports("ssse3"))
+		features |= CPU_SSSE3;
+	if (__builtin_cpu_supports("sse4.2"))
+		features |= CPU_SSE42;
+	if (__builtin_cpu_supports("avx2"))
+		features |= CPU_AVX2;
+	if (__builtin_cpu_supports("avx512bw"))
+		features |= CPU_AVX512BW;
+	#endif
+
+	return features;
+}
@@ -0,0 +1,21 @@
+#ifndef cpu_h
+#define cpu_h
+
+#include "tyson.h"
+
+// cpu_features bits.
+#define CPU_SSE2      (1 << 0)
+#define CPU_SSSE3     (1 << 1)
+#define CPU_SSE42     (1 << 2)
+#define CPU_AVX2      (1 << 3)
+#define CPU_AVX512BW  (1 << 4)
+
+/*
+	CPU Features:
+		What the cpu we're running on supports, as CPU_* bits, for picking
+		between kernels built for several instruction sets. Always 0 off
+		x86-64, where only the portable kernels are built.
+*/
+u64 cpu_features();
+
+#endif
@@ -0,0 +1,250 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tyson.h"
+#include "dbinfo.h"
+
+typedef struct {
+	const u8* p;
+	const u8* end;
+	u8        bad;
+} Reader;
+
+
+static u64
+read_uleb(Reader* r)
+{
+	u64 value = 0;
+	u8  shift = 0, byte;
+
+	do {
+		if (r->p >= r->end || shift > 63) {
+			r->bad = TRUE;
+			return 0;
+		}
+		byte = *r->p++;
+		value |= (u64) (byte & 0x7f) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+	return value;
+}
+
+
+static s64
+read_sleb(Reader* r)
+{
+	u64 value = read_uleb(r);
+
+	return (value & 1) ? -(s64) (value >> 1) - 1 : (s64) (value >> 1);
+}
+
+
+// Each string is preceded by at least its length byte, so names is never outgrown.
+static const char*
+read_name(Reader* r, char** names)
+{
+	u64   len = read_uleb(r);
+	char* name = *names;
+
+	if (r->bad || len > (u64) (r->end - r->p)) {
+		r->bad = TRUE;
+		return "";
+	}
+	memcpy(name, r->p, len);
+	name[len] = 0;
+	r->p += len;
+	*names += len + 1;
+	return name;
+}
+
+
+// A count can't be more than the bytes left, every entry takes at least one.
+static void*
+read_table(Reader* r, u64* count, u64 entry_size)
+{
+	void* table;
+
+	*count = read_uleb(r);
+	if (r->bad || *count > (u64) (r->end - r->p)) {
+		r->bad = TRUE;
+		*count = 0;
+		return 0;
+	}
+	table = malloc((*count ? *count : 1) * entry_size);
+	if (!table)
+		r->bad = TRUE;
+	return table;
+}
+
+
+static int
+decode(DebugInfo* info, const u8* bytes, u64 size)
+{
+	Reader r = {bytes, bytes + size, FALSE};
+	char*  names = info->names;
+	u64    i, addr = 0, line = 0;
+
+	if (size < 5 || memcmp(bytes, DEBUG_MAGIC, 4) || bytes[4] != DEBUG_VERSION)
+		return -1;
+	r.p += 5;
+
+	info->source = read_name(&r, &names);
+
+	info->labels = (DbLabel*) read_table(&r, &info->label_count, sizeof(DbLabel));
+	for (i=0; i < info->label_count && !r.bad; ++i) {
+		addr += read_uleb(&r);
+		info->labels[i].addr = addr;
+		info->labels[i].name = read_name(&r, &names);
+	}
+	if (r.bad)
+		return -1;
+
+	addr = 0;
+	info->lines = (DbLine*) read_table(&r, &info->line_count, sizeof(DbLine));
+	for (i=0; i < info->line_count && !r.bad; ++i) {
+		addr += read_uleb(&r);
+		line += read_sleb(&r);
+		info->lines[i].addr = addr;
+		info->lines[i].line = line;
+	}
+	if (r.bad)
+		return -1;
+
+	info->symbols = (DbSymbol*) read_table(&r, &info->symbol_count, sizeof(DbSymbol));
+	for (i=0; i < info->symbol_count && !r.bad; ++i) {
+		if (r.p >= r.end) {
+			r.bad = TRUE;
+			break;
+		}
+		info->symbols[i].dtype = *r.p++;
+		info->symbols[i].value = read_sleb(&r);
+		info->symbols[i].name  = read_name(&r, &names);
+	}
+	return r.bad ? -1 : 0;
+}
+
+
+/*
+	Read Debug Info:
+		Reads and decodes the debug info of the image at path, 0 if it has
+		none or it doesn't make sense.
+*/
+DebugInfo*
+read_debug_info(const char* path)
+{
+	FILE* f = fopen(path, "rb");
+	u8    meta[METADATA_SIZE];
+	u64   base, size;
+	u8*   bytes;
+	DebugInfo* info;
+
+	if (!f)
+		return 0;
+
+	if (fread(meta, 1, METADATA_SIZE, f) != METADATA_SIZE) {
+		fclose(f);
+		return 0;
+	}
+	base = *((u64*) (meta + DEBUG_BASE_OFFS));
+	size = *((u64*) (meta + DEBUG_SIZE_OFFS));
+	if (!size || fseek(f, (long) base, SEEK_SET) < 0) {
+		fclose(f);
+		return 0;
+	}
+
+	bytes = (u8*) malloc(size);
+	info  = (DebugInfo*) calloc(1, sizeof(DebugInfo));
+	if (info)
+		info->names = (char*) malloc(size);
+	if (!bytes || !info || !info->names || fread(bytes, 1, size, f) != size || decode(info, bytes, size) < 0) {
+		free_debug_info(info);
+		info = 0;
+	}
+
+	free(bytes);
+	fclose(f);
+	return info;
+}
+
+
+void
+free_debug_info(DebugInfo* info)
+{
+	if (!info)
+		return;
+	free(info->labels);
+	free(info->lines);
+	free(info->symbols);
+	free(info->names);
+	free(info);
+}
+
+
+// The last label at or before addr, with how far past it addr is.
+const char*
+dbinfo_label(DebugInfo* info, u64 addr, u64* delta)
+{
+	u64 lo = 0, hi = info->label_count, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (info->labels[mid].addr <= addr)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (!lo)
+		return 0;
+	if (delta)
+		*delta = addr - info->labels[lo - 1].addr;
+	return info->labels[lo - 1].name;
+}
+
+
+// Source line of the instruction addr falls in, 0 if it isn't known.
+u64
+dbinfo_line(DebugInfo* info, u64 addr)
+{
+	u64 lo = 0, hi = info->line_count, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (info->lines[mid].addr <= addr)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo ? info->lines[lo - 1].line : 0;
+}
+
+
+// TRUE if an instruction starts at addr, the line table has every one.
+u8
+dbinfo_instr(DebugInfo* info, u64 addr)
+{
+	u64 lo = 0, hi = info->line_count, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (info->lines[mid].addr < addr)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo < info->line_count && info->lines[lo].addr == addr;
+}
+
+
+// First sym directive that gave value, heap offsets mostly.
+const char*
+dbinfo_symbol(DebugInfo* info, s64 value)
+{
+	u64 i;
+
+	for (i=0; i < info->symbol_count; ++i) {
+		if (info->symbols[i].value == value)
+			return info->symbols[i].name;
+	}
+	return 0;
+}
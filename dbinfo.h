@@ -0,0 +1,60 @@
+#ifndef dbinfo_h
+#define dbinfo_h
+
+#include "tyson.h"
+
+#define DEBUG_MAGIC    "TYDB"
+#define DEBUG_VERSION  (1)
+
+/*
+	Debug Info:
+		What tyasm.py -g appends to an image after the export table, found
+		through the DEBUG_BASE and DEBUG_SIZE metadata words. Unsigned
+		numbers are LEB128 varints, signed ones zigzagged first, and the
+		addresses and line numbers are deltas from the entry before:
+
+			"TYDB" u8 version
+			source path length, path
+			label count, per label by address: addr, name length, name
+			line count, per instruction by address: addr, line
+			symbol count, per sym directive: u8 type, value, name length, name
+
+		It is never part of the process image. read_debug_info decodes it
+		straight from the file, and processes only do so the first time
+		process_debug_info is asked for it.
+*/
+typedef struct {
+	u64         addr;
+	const char* name;
+} DbLabel;
+
+typedef struct {
+	u64 addr;
+	u64 line;
+} DbLine;
+
+typedef struct {
+	u8          dtype;
+	s64         value;
+	const char* name;
+} DbSymbol;
+
+struct DebugInfo {
+	const char* source;
+	DbLabel*    labels;
+	u64         label_count;
+	DbLine*     lines;
+	u64         line_count;
+	DbSymbol*   symbols;
+	u64         symbol_count;
+	char*       names;  // every string above, back to back.
+};
+
+DebugInfo*  read_debug_info(const char*);
+void        free_debug_info(DebugInfo*);
+const char* dbinfo_label(DebugInfo*, u64, u64*);
+u64         dbinfo_line(DebugInfo*, u64);
+u8          dbinfo_instr(DebugInfo*, u64);
+const char* dbinfo_symbol(DebugInfo*, s64);
+
+#endif
@@ -4,11 +4,13 @@
 #include <ctype.h>
 
 #include "tyson.h"
+#include "opcodes.h"
 #include "debug.h"
+#include "dbinfo.h"
 
-const char* dbmenu_str = "\n\t[0]end [1]run [2]step [3]stop [4]reset [5]print-stk [6]print-mem";
-const char* input_msg  = "\n --> ";
-const char* invalid_input_msg = "\n\tinvalid input, try again.";
+const char* const dbmenu_str = "\n\t[0]end [1]run [2]step [3]stop [4]reset [5]print-stk [6]print-mem [7]break [8]clear";
+const char* const input_msg  = "\n --> ";
+const char* const invalid_input_msg = "\n\tinvalid input, try again.";
 
 u8
 is_int(const char* str)
@@ -68,6 +70,7 @@ u8 dbmenu_input()
 		    	free(str);
 			    switch (input) {
 				    case END: case RUN: case STEP: case STOP: case RESET: case PRINT_STK: case PRINT_MEM:
+				    case BREAK: case CLEAR:
 					    return (u8) input;
 				    default:
 					    printf("%s", invalid_input_msg);
@@ -83,3 +86,181 @@ u8 dbmenu_input()
 		} 
 	}
 }
+
+
+// Where ip is, with the label and source line when the image has debug info.
+void
+dbprint_where(Process* pro, u8* ip)
+{
+	DebugInfo*  info = process_debug_info(pro);
+	u64         offs = ip - pro->img, delta = 0, line;
+	const char* label;
+	const char* file;
+
+	printf("\n\tip %lu %s", offs, (*ip < OPCOUNT) ? opcode_strmap[*ip] : "?");
+	if (!info)
+		return;
+
+	label = dbinfo_label(info, offs, &delta);
+	if (label)
+		printf(delta ? "  %s+%lu" : "  %s", label, delta);
+
+	line = dbinfo_line(info, offs);
+	if (line) {
+		file = strrchr(info->source, '/');
+		printf("  %s:%lu", file ? file + 1 : info->source, line);
+	}
+}
+
+
+// Names the heap offset if a sym directive gave it.
+void
+dbprint_symbol(Process* pro, u64 addr)
+{
+	DebugInfo*  info = process_debug_info(pro);
+	const char* name = info ? dbinfo_symbol(info, (s64) addr) : 0;
+
+	if (name)
+		printf("  (%s)", name);
+}
+
+
+/*
+	Read Address:
+		Prompts until given the address of an instruction, as an img
+		offset or a label name. Only the line table from tyasm.py -g tells
+		an opcode from the operand bytes around it, so without debug info
+		no address is taken and -1 is returned.
+*/
+s64
+dbread_addr(Process* pro, const char* prompt)
+{
+	DebugInfo* info = process_debug_info(pro);
+	u64 addr, i;
+	char* str;
+
+	if (!info || !info->line_count) {
+		printf("\n\tno debug info, assemble the image with -g to set breakpoints.");
+		return -1;
+	}
+
+	for (;;) {
+		printf("\n\t%s\n\t\taddress or label: ", prompt);
+		str = (char*) get_stdin_str();
+		addr = 0;
+		if (is_int(str)) {
+			addr = (u64) atoll(str);
+		} else {
+			for (i=0; i < info->label_count; ++i) {
+				if (strcmp(info->labels[i].name, str) == 0) {
+					addr = info->labels[i].addr;
+					break;
+				}
+			}
+		}
+		free(str);
+		if (dbinfo_instr(info, addr))
+			return (s64) addr;
+		printf("%s", invalid_input_msg);
+	}
+}
+
+
+// Adds a breakpoint at the text offset offs, -1 if the table is full.
+int
+db_break_set(Process* pro, u64 offs)
+{
+	Breakpoints* b = pro->breaks;
+
+	if (!b) {
+		b = pro->breaks = (Breakpoints*) calloc(1, sizeof(Breakpoints));
+		if (!b)
+			return -1;
+	}
+	if (db_break_find(pro, (pro->img) + offs) >= 0)
+		return 0;
+	if (b->count == DB_BREAKPOINTS)
+		return -1;
+
+	b->offs[b->count++] = offs;
+	return 0;
+}
+
+
+void
+db_break_clear(Process* pro, u64 offs)
+{
+	Breakpoints* b = pro->breaks;
+	int k = db_break_find(pro, (pro->img) + offs);
+
+	if (k < 0)
+		return;
+	--b->count;
+	b->offs[k] = b->offs[b->count];
+	b->op[k]   = b->op[b->count];
+}
+
+
+// Index of the breakpoint at ip, -1 if there isn't one.
+int
+db_break_find(Process* pro, u8* ip)
+{
+	Breakpoints* b = pro->breaks;
+	u64 offs = ip - pro->img, k;
+
+	if (!b)
+		return -1;
+	for (k=0; k < b->count; ++k) {
+		if (b->offs[k] == offs)
+			return (int) k;
+	}
+	return -1;
+}
+
+
+// Opcode a patched in breakpoint at ip covers, -1 if the one there was assembled.
+int
+db_break_op(Process* pro, u8* ip)
+{
+	int k;
+
+	if (!pro->breaks || !pro->breaks->armed)
+		return -1;
+	k = db_break_find(pro, ip);
+	return (k < 0) ? -1 : pro->breaks->op[k];
+}
+
+
+// Patches every breakpoint in but any at skip, which the caller puts in itself.
+void
+db_arm(Process* pro, u8* skip)
+{
+	Breakpoints* b = pro->breaks;
+	u8* p;
+	u64 k;
+
+	if (!b)
+		return;
+	db_disarm(pro);
+	for (k=0; k < b->count; ++k) {
+		p = (pro->img) + b->offs[k];
+		b->op[k] = *p;
+		if (p != skip)
+			*p = BREAKPOINT;
+	}
+	b->armed = TRUE;
+}
+
+
+void
+db_disarm(Process* pro)
+{
+	Breakpoints* b = pro->breaks;
+	u64 k;
+
+	if (!b || !b->armed)
+		return;
+	for (k=0; k < b->count; ++k)
+		*((pro->img) + b->offs[k]) = b->op[k];
+	b->armed = FALSE;
+}
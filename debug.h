@@ -1,7 +1,7 @@
 #ifndef debug_h
 #define debug_h
 
-#define DBACT_COUNT 7
+#define DBACT_COUNT 9
 
 #define END         0
 #define RUN         1
@@ -10,22 +10,56 @@
 #define RESET       4
 #define PRINT_STK   5
 #define PRINT_MEM   6
+#define BREAK       7
+#define CLEAR       8
 
 #define build_dbtable()                  			       \
-	static void* dbtable[DBACT_COUNT]= {&&dbact_end,       \
+	static void* const dbtable[DBACT_COUNT]= {&&dbact_end,       \
 		                                &&dbact_run,       \
 		                                &&dbact_step,      \
 		                                &&dbact_stop,      \
 		                                &&dbact_reset,     \
 		                                &&dbact_print_stk, \
-		                                &&dbact_print_mem}
+		                                &&dbact_print_mem, \
+		                                &&dbact_break,     \
+		                                &&dbact_clear}
 
-const char* dbmenu_str;
-const char* input_msg;
-const char* invalid_input_msg;
+#define DB_BREAKPOINTS (32)
+
+/*
+	Breakpoints:
+		Set from the debugger menu, each by patching BREAKPOINT over the
+		opcode at its address in the process' own copy of the text, the
+		image file and any text image it came from are never touched.
+		They're only patched in while the process runs, db_start takes
+		them all out again so what it shows is the real text, and running
+		on from one dispatches its instruction with the rest patched in,
+		putting it back once that instruction is done.
+
+		PLSTART workers that reach one run the opcode it covers.
+*/
+struct Breakpoints {
+	u64 count;
+	u64 offs[DB_BREAKPOINTS];
+	u8  op[DB_BREAKPOINTS]; // opcode each covers, while armed.
+	u8  armed;
+};
+
+extern const char* const dbmenu_str;
+extern const char* const input_msg;
+extern const char* const invalid_input_msg;
 
 u8  is_int(const char*);
 u8* get_stdin_str();
 u8  dbmenu_input();
+void dbprint_where(Process*, u8*);
+void dbprint_symbol(Process*, u64);
+s64  dbread_addr(Process*, const char*);
+int  db_break_set(Process*, u64);
+void db_break_clear(Process*, u64);
+int  db_break_find(Process*, u8*);
+int  db_break_op(Process*, u8*);
+void db_arm(Process*, u8*);
+void db_disarm(Process*);
 
 #endif
@@ -0,0 +1,546 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "tyson.h"
+#include "fileio.h"
+
+static const int open_flags[7] = {0,
+                                  O_RDONLY,
+                                  O_WRONLY | O_CREAT | O_TRUNC,
+                                  O_WRONLY | O_CREAT | O_APPEND,
+                                  O_RDWR,
+                                  O_RDWR | O_CREAT | O_TRUNC,
+                                  O_RDWR | O_CREAT | O_APPEND};
+
+
+// read() and write() that carry on after interrupts and short transfers.
+static s64
+read_all(int fd, u8* bp, u64 n)
+{
+	u64 done = 0;
+	ssize_t got;
+
+	while (done < n) {
+		got = read(fd, bp + done, n - done);
+		if (got > 0)
+			done += (u64) got;
+		else if (got < 0 && errno == EINTR)
+			continue;
+		else if (got < 0 && !done)
+			return -1;
+		else
+			break;
+	}
+
+	return (s64) done;
+}
+
+static s64
+write_all(int fd, const u8* bp, u64 n)
+{
+	u64 done = 0;
+	ssize_t put;
+
+	while (done < n) {
+		put = write(fd, bp + done, n - done);
+		if (put > 0)
+			done += (u64) put;
+		else if (put < 0 && errno == EINTR)
+			continue;
+		else
+			return -1;
+	}
+
+	return (s64) done;
+}
+
+// A single read() for refills, so a pipe or terminal hands back whatever has arrived.
+static s64
+read_some(int fd, u8* bp, u64 n)
+{
+	ssize_t got;
+
+	do {
+		got = read(fd, bp, n);
+	} while (got < 0 && errno == EINTR);
+
+	return (s64) got;
+}
+
+
+FileTable*
+new_file_table()
+{
+	FileTable* ft = (FileTable*) malloc(sizeof(FileTable));
+	u64 i;
+
+	if (!ft)
+		return 0;
+
+	for (i=0; i < FILE_TABLE_SIZE; ++i) {
+		ft->files[i].fd      = (i < 3) ? (int) i : -1;
+		ft->files[i].owned   = FALSE;
+		ft->files[i].writing = FALSE;
+		ft->files[i].buf     = 0;
+		ft->files[i].pos     = 0;
+		ft->files[i].end     = 0;
+	}
+
+	return ft;
+}
+
+
+void
+free_file_table(FileTable* ft)
+{
+	u64 i;
+
+	close_files(ft);
+	for (i=0; i < 3; ++i)
+		free(ft->files[i].buf);
+	free(ft);
+}
+
+
+static VMFile*
+get_file(FileTable* ft, s64 fd)
+{
+	VMFile* f;
+
+	if (fd < 0 || fd >= FILE_TABLE_SIZE)
+		return 0;
+
+	f = &ft->files[fd];
+	if (f->fd < 0)
+		return 0;
+	if (!f->buf && !(f->buf = (u8*) malloc(FILE_BUFFER_SIZE)))
+		return 0;
+
+	return f;
+}
+
+
+/*
+	Sync:
+		Empties a file's buffer so the os file position matches the VM's.
+		Pending writes are written out, unread read-ahead is given back by
+		seeking the os file back over it. Pipes, terminals and sockets
+		can't seek, so there whatever read-ahead is left is dropped.
+*/
+static s64
+sync_file(VMFile* f)
+{
+	s64 retval = 0;
+
+	if (f->writing) {
+		if (f->end && write_all(f->fd, f->buf, f->end) < 0)
+			retval = -1;
+	} else if (f->pos < f->end) {
+		lseek(f->fd, -((off_t) (f->end - f->pos)), SEEK_CUR);
+	}
+
+	f->writing = FALSE;
+	f->pos = f->end = 0;
+	return retval;
+}
+
+
+void
+flush_files(FileTable* ft)
+{
+	u64 i;
+
+	for (i=0; i < FILE_TABLE_SIZE; ++i) {
+		if (ft->files[i].fd >= 0 && ft->files[i].writing)
+			sync_file(&ft->files[i]);
+	}
+}
+
+
+// Closes every file the process opened, leaving the standard streams.
+void
+close_files(FileTable* ft)
+{
+	u64 i;
+
+	flush_files(ft);
+	for (i=3; i < FILE_TABLE_SIZE; ++i) {
+		if (ft->files[i].fd >= 0)
+			file_close(ft, (s64) i);
+	}
+}
+
+
+/*
+	Open File:
+		Opens path with one of the fopen mode codes and returns the new
+		descriptor, or -1 if the mode is bad, the table is full or the os
+		refuses.
+*/
+s64
+file_open(FileTable* ft, const char* path, u64 mode)
+{
+	u64 i;
+	int fd;
+
+	if (mode < READ_MODE || mode > APPEND_UPDATE_MODE)
+		return -1;
+
+	for (i=3; i < FILE_TABLE_SIZE; ++i) {
+		if (ft->files[i].fd < 0)
+			break;
+	}
+	if (i == FILE_TABLE_SIZE)
+		return -1;
+
+	fd = open(path, open_flags[mode], 0666);
+	if (fd < 0)
+		return -1;
+
+	ft->files[i].fd      = fd;
+	ft->files[i].owned   = TRUE;
+	ft->files[i].writing = FALSE;
+	ft->files[i].pos     = 0;
+	ft->files[i].end     = 0;
+	return (s64) i;
+}
+
+
+s64
+file_close(FileTable* ft, s64 fd)
+{
+	VMFile* f;
+	s64 retval;
+
+	if (fd < 3 || !(f = get_file(ft, fd)))
+		return -1;
+
+	retval = sync_file(f);
+	if (close(f->fd) < 0)
+		retval = -1;
+
+	free(f->buf);
+	f->buf = 0;
+	f->fd = -1;
+	f->owned = FALSE;
+	return retval;
+}
+
+
+// Next byte from the file, or -1 at end of file or on error.
+s64
+file_getc(FileTable* ft, s64 fd)
+{
+	VMFile* f = get_file(ft, fd);
+	s64 got;
+
+	if (!f)
+		return -1;
+
+	if (f->pos == f->end) {
+		if (f->writing)
+			sync_file(f);
+		got = read_some(f->fd, f->buf, FILE_BUFFER_SIZE);
+		if (got <= 0)
+			return -1;
+		f->pos = 0;
+		f->end = (u64) got;
+	}
+
+	return (s64) f->buf[f->pos++];
+}
+
+
+s64
+file_putc(FileTable* ft, s64 fd, u8 byte)
+{
+	VMFile* f = get_file(ft, fd);
+
+	if (!f)
+		return -1;
+
+	if (!f->writing)
+		sync_file(f);
+	f->writing = TRUE;
+
+	if (f->end == FILE_BUFFER_SIZE && sync_file(f) < 0)
+		return -1;
+	f->writing = TRUE;
+
+	f->buf[f->end++] = byte;
+	return (s64) byte;
+}
+
+
+// Returns the new position from the start of the file, or -1.
+s64
+file_seek(FileTable* ft, s64 fd, s64 offset, u64 whence)
+{
+	VMFile* f = get_file(ft, fd);
+	int how;
+
+	if (!f)
+		return -1;
+
+	switch (whence) {
+		case SEEK_FROM_START: how = SEEK_SET; break;
+		case SEEK_FROM_CUR:   how = SEEK_CUR; break;
+		case SEEK_FROM_END:   how = SEEK_END; break;
+		default:
+			return -1;
+	}
+
+	if (sync_file(f) < 0)
+		return -1;
+	return (s64) lseek(f->fd, (off_t) offset, how);
+}
+
+
+/*
+	Bulk Read:
+		Reads up to n bytes into dst, returning how many were read, 0 at end
+		of file or -1 on error. Buffered read-ahead is used up first, then
+		anything of a buffer's size or more is read straight into dst, only
+		smaller remainders go through the buffer.
+*/
+s64
+file_read(FileTable* ft, s64 fd, u8* dst, u64 n)
+{
+	VMFile* f = get_file(ft, fd);
+	u64 done = 0, have;
+	s64 got;
+
+	if (!f)
+		return -1;
+	if (f->writing && sync_file(f) < 0)
+		return -1;
+
+	have = f->end - f->pos;
+	if (have) {
+		done = (have < n) ? have : n;
+		memcpy(dst, f->buf + f->pos, done);
+		f->pos += done;
+	}
+
+	if (done < n && (n - done) >= FILE_BUFFER_SIZE) {
+		got = read_all(f->fd, dst + done, n - done);
+		if (got < 0)
+			return done ? (s64) done : -1;
+		done += (u64) got;
+	} else if (done < n) {
+		got = read_some(f->fd, f->buf, FILE_BUFFER_SIZE);
+		if (got < 0)
+			return done ? (s64) done : -1;
+		f->pos = 0;
+		f->end = (u64) got;
+		have = ((n - done) < f->end) ? (n - done) : f->end;
+		memcpy(dst + done, f->buf, have);
+		f->pos = have;
+		done += have;
+	}
+
+	return (s64) done;
+}
+
+
+/*
+	Bulk Write:
+		Writes n bytes from src, returning n or -1 on error. Small writes
+		are gathered in the buffer, anything that won't fit flushes it and
+		goes straight to the os.
+*/
+s64
+file_write(FileTable* ft, s64 fd, const u8* src, u64 n)
+{
+	VMFile* f = get_file(ft, fd);
+
+	if (!f)
+		return -1;
+
+	if (!f->writing)
+		sync_file(f);
+	f->writing = TRUE;
+
+	if ((f->end + n) <= FILE_BUFFER_SIZE) {
+		memcpy(f->buf + f->end, src, n);
+		f->end += n;
+		return (s64) n;
+	}
+
+	if (sync_file(f) < 0)
+		return -1;
+	f->writing = TRUE;
+
+	if (n < FILE_BUFFER_SIZE) {
+		memcpy(f->buf, src, n);
+		f->end = n;
+		return (s64) n;
+	}
+
+	return write_all(f->fd, src, n);
+}
+
+
+/*
+	OS Descriptor:
+		The host descriptor behind fd, with its buffer synced so that
+		positioned i/o on it, as the async instructions do, sees the same
+		file the buffered instructions do. -1 if fd isn't open.
+*/
+int
+file_fd(FileTable* ft, s64 fd)
+{
+	VMFile* f = get_file(ft, fd);
+
+	if (!f)
+		return -1;
+	sync_file(f);
+	return f->fd;
+}
+
+
+// Points one of the standard streams, slot 0, 1 or 2, at another host descriptor.
+void
+file_redirect(FileTable* ft, s64 fd, int host)
+{
+	VMFile* f;
+
+	if (fd < 0 || fd > 2)
+		return;
+
+	f = &ft->files[fd];
+	if (f->writing)
+		sync_file(f);
+	f->fd = host;
+}
+
+
+static const int map_advice[4] = {MADV_NORMAL,
+                                  MADV_SEQUENTIAL,
+                                  MADV_RANDOM,
+                                  MADV_WILLNEED};
+
+
+/*
+	Find Map Space:
+		First fit for size bytes in the map window among the regions
+		already mapped. Returns the offset or 0 when nothing fits, 0 being
+		inside the image and so never a window offset.
+*/
+static u64
+find_map_space(Process* pro, u64 size)
+{
+	u64 window_end = pro->img_span;
+	u64 at = pro->map_base, i;
+	u8  moved = TRUE;
+
+	while (moved) {
+		moved = FALSE;
+		for (i=0; i < MAP_TABLE_SIZE; ++i) {
+			if (pro->maps[i].size && at < (pro->maps[i].offs + pro->maps[i].size)
+			                      && pro->maps[i].offs < (at + size)) {
+				at = pro->maps[i].offs + pro->maps[i].size;
+				moved = TRUE;
+			}
+		}
+	}
+
+	return ((at + size) <= window_end) ? at : 0;
+}
+
+
+/*
+	Map File:
+		Maps the file at path read-only into the process' map window and
+		returns its img-relative offset, so every img_byte addressed
+		instruction reads it in place. The file's size is written to size.
+		advice is one of the MAP_ADVISE codes. Returns -1 if the file won't
+		open or map or there's no room, an empty file maps to offset 0
+		with size 0.
+*/
+s64
+file_map(Process* pro, const char* path, u64 advice, u64* size)
+{
+	u64   page = (u64) sysconf(_SC_PAGESIZE);
+	u64   span, offs, i;
+	struct stat st;
+	void* at;
+	int   fd;
+
+	*size = 0;
+	for (i=0; i < MAP_TABLE_SIZE; ++i) {
+		if (!pro->maps[i].size)
+			break;
+	}
+	if (i == MAP_TABLE_SIZE || advice > MAP_ADVISE_WILLNEED)
+		return -1;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return -1;
+	if (fstat(fd, &st) < 0) {
+		close(fd);
+		return -1;
+	}
+	if (!st.st_size) {
+		close(fd);
+		return 0;
+	}
+
+	span = ((u64) st.st_size + page - 1) & ~(page - 1);
+	offs = find_map_space(pro, span);
+	if (!offs) {
+		close(fd);
+		return -1;
+	}
+
+	at = mmap(pro->img + offs, span, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+	close(fd);
+	if (at == MAP_FAILED)
+		return -1;
+
+	madvise(at, span, map_advice[advice]);
+	pro->maps[i].offs = offs;
+	pro->maps[i].size = span;
+	*size = (u64) st.st_size;
+	return (s64) offs;
+}
+
+
+// Gives a mapped region back to the window, -1 if offs isn't one.
+s64
+file_unmap(Process* pro, s64 offs)
+{
+	u64 i;
+
+	for (i=0; i < MAP_TABLE_SIZE; ++i) {
+		if (pro->maps[i].size && pro->maps[i].offs == (u64) offs)
+			break;
+	}
+	if (i == MAP_TABLE_SIZE)
+		return -1;
+
+	// Mapping fresh reserved space over the file keeps the window ours.
+	mmap(pro->img + offs, pro->maps[i].size, PROT_NONE,
+	     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+	pro->maps[i].offs = 0;
+	pro->maps[i].size = 0;
+	return 0;
+}
+
+
+void
+unmap_files(Process* pro)
+{
+	u64 i;
+
+	for (i=0; i < MAP_TABLE_SIZE; ++i) {
+		if (pro->maps[i].size)
+			file_unmap(pro, (s64) pro->maps[i].offs);
+	}
+}
@@ -0,0 +1,65 @@
+#ifndef fileio_h
+#define fileio_h
+
+#include "tyson.h"
+
+#define FILE_TABLE_SIZE   (64)
+#define FILE_BUFFER_SIZE  (1 << 20)
+
+// fopen mode codes, as in tyson.py's fopen_codemap.
+#define READ_MODE           1
+#define WRITE_MODE          2
+#define APPEND_MODE         3
+#define READ_UPDATE_MODE    4
+#define WRITE_UPDATE_MODE   5
+#define APPEND_UPDATE_MODE  6
+
+// seekf whence codes.
+#define SEEK_FROM_START     0
+#define SEEK_FROM_CUR       1
+#define SEEK_FROM_END       2
+
+// mapf advice codes, passed on to madvise.
+#define MAP_ADVISE_NORMAL   0
+#define MAP_ADVISE_SEQ      1
+#define MAP_ADVISE_RANDOM   2
+#define MAP_ADVISE_WILLNEED 3
+
+/*
+	VM File:
+		One slot of a process' descriptor table. Reads and writes go
+		through buf, which holds either read-ahead, bytes pos to end, or
+		pending writes, bytes 0 to end, never both. Slots 0, 1 and 2 are
+		the host's stdin, stdout and stderr and are never closed.
+*/
+typedef struct {
+	int  fd;
+	u8   owned;
+	u8   writing;
+	u8*  buf;
+	u64  pos;
+	u64  end;
+} VMFile;
+
+struct FileTable {
+	VMFile files[FILE_TABLE_SIZE];
+};
+
+FileTable* new_file_table();
+void       free_file_table(FileTable*);
+void       close_files(FileTable*);
+void       flush_files(FileTable*);
+s64        file_open(FileTable*, const char*, u64);
+s64        file_close(FileTable*, s64);
+s64        file_getc(FileTable*, s64);
+s64        file_putc(FileTable*, s64, u8);
+s64        file_seek(FileTable*, s64, s64, u64);
+s64        file_read(FileTable*, s64, u8*, u64);
+s64        file_write(FileTable*, s64, const u8*, u64);
+int        file_fd(FileTable*, s64);
+void       file_redirect(FileTable*, s64, int);
+s64        file_map(Process*, const char*, u64, u64*);
+s64        file_unmap(Process*, s64);
+void       unmap_files(Process*);
+
+#endif
@@ -0,0 +1,97 @@
+#include <string.h>
+
+#include "tyson.h"
+#include "heap.h"
+
+#define block_word(offs) \
+	((u64*) ((pro->img) + (offs)))
+
+
+void
+heap_reset(Process* pro)
+{
+	u64* base = (u64*) ((pro->img) + HEAP_BASE_OFFS);
+	u64* size = (u64*) ((pro->img) + HEAP_SIZE_OFFS);
+
+	// Blocks are carved downward from the end, aligned as it's reached.
+	pro->heap.base = *base;
+	pro->heap.top  = ((*base) + (*size)) & ~((u64) HEAP_ALIGN - 1);
+	if (pro->heap.top < pro->heap.base)
+		pro->heap.top = pro->heap.base;
+	memset(pro->heap.free, 0, sizeof(pro->heap.free));
+}
+
+
+static u64
+size_class(u64 size)
+{
+	u64 class = HEAP_MIN_CLASS;
+
+	while (((u64) 1 << class) < size)
+		++class;
+	return class;
+}
+
+
+static void
+count_alloc(Process* pro, u64 bytes)
+{
+	++pro->usage.heap_allocs;
+	pro->usage.heap_bytes += bytes;
+	pro->usage.heap_live  += bytes;
+	if (pro->usage.heap_live > pro->usage.heap_peak)
+		pro->usage.heap_peak = pro->usage.heap_live;
+}
+
+
+u64
+heap_alloc(Process* pro, u64 size)
+{
+	u64 class, offs, bytes;
+
+	if (size > ((u64) 1 << (HEAP_CLASSES - 1)) - HEAP_HEADER_SIZE)
+		return 0;
+
+	class = size_class(size + HEAP_HEADER_SIZE);
+
+	bytes = (u64) 1 << class;
+
+	offs = pro->heap.free[class];
+	if (offs) {
+		pro->heap.free[class] = *block_word(offs);
+		count_alloc(pro, bytes);
+		return offs;
+	}
+
+	if ((pro->heap.top - pro->heap.base) < bytes)
+		return 0;
+
+	pro->heap.top -= bytes;
+	offs = pro->heap.top + HEAP_HEADER_SIZE;
+	*block_word(offs - HEAP_HEADER_SIZE) = class;
+	count_alloc(pro, bytes);
+	return offs;
+}
+
+
+void
+heap_free(Process* pro, u64 offs)
+{
+	u64 class;
+
+	if (!offs)
+		return;
+
+	class = *block_word(offs - HEAP_HEADER_SIZE);
+	*block_word(offs) = pro->heap.free[class];
+	pro->heap.free[class] = offs;
+	pro->usage.heap_live -= (u64) 1 << class;
+}
+
+
+// Usable bytes of the block at offs.
+u64
+heap_capacity(Process* pro, u64 offs)
+{
+	return ((u64) 1 << *block_word(offs - HEAP_HEADER_SIZE)) - HEAP_HEADER_SIZE;
+}
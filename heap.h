@@ -0,0 +1,33 @@
+#ifndef heap_h
+#define heap_h
+
+#include "tyson.h"
+
+// Smallest block is 1 << HEAP_MIN_CLASS bytes, header included.
+#define HEAP_MIN_CLASS    (5)
+#define HEAP_HEADER_SIZE  (8)
+#define HEAP_ALIGN        (16)
+
+/*
+	Heap:
+		Allocator over the process' heap region for the instructions that
+		need storage that grows, length-prefixed strings first of all.
+		Blocks are powers of two, each with a one word header holding its
+		size class, and freed blocks go on a list per class to be handed
+		out again as they are. The region is carved from the top down,
+		leaving the bottom of the heap to the fixed addresses programs
+		already use, and never shrinks, so growth by doubling, the common
+		case, recycles the blocks it outgrows. What's live and the most
+		that ever was are counted in the process' usage.
+
+		All addresses given and taken are img-relative offsets of a
+		block's usable bytes, 0 meaning none. State is per process and not
+		locked, PLSTART workers must not allocate.
+*/
+
+void heap_reset(Process*);
+u64  heap_alloc(Process*, u64);
+void heap_free(Process*, u64);
+u64  heap_capacity(Process*, u64);
+
+#endif
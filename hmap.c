@@ -0,0 +1,326 @@
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <emmintrin.h>
+#endif
+
+#include "tyson.h"
+#include "heap.h"
+#include "hmap.h"
+
+// Control bytes, a full slot's is its hash's top 7 bits.
+#define CTRL_EMPTY    (0x80)
+#define CTRL_DELETED  (0xfe)
+
+#define HMAP_MIN_CAP  (16)
+#define HMAP_SLOT     (2 * wordsize)
+
+#define ctrl_bytes(m) \
+	((pro->img) + (m)->table)
+
+#define slot_words(m, i) \
+	((u64*) ((pro->img) + (m)->table + (m)->cap + HMAP_GROUP + (i) * HMAP_SLOT))
+
+#define table_size(cap) \
+	((cap) + HMAP_GROUP + (cap) * HMAP_SLOT)
+
+
+// Bit i set where byte i of the group equals b.
+static u32
+group_match(const u8* g, u8 b)
+{
+	#if defined(__x86_64__)
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) g), _mm_set1_epi8((char) b)));
+	#else
+	u32 mask = 0, i;
+
+	for (i=0; i < HMAP_GROUP; ++i)
+		if (g[i] == b)
+			mask |= 1 << i;
+	return mask;
+	#endif
+}
+
+
+// Bit i set where slot i of the group is empty or deleted, both with the top bit.
+static u32
+group_free(const u8* g)
+{
+	#if defined(__x86_64__)
+	return _mm_movemask_epi8(_mm_loadu_si128((const __m128i*) g));
+	#else
+	u32 mask = 0, i;
+
+	for (i=0; i < HMAP_GROUP; ++i)
+		if (g[i] & 0x80)
+			mask |= 1 << i;
+	return mask;
+	#endif
+}
+
+
+static u64
+hash_key(Process* pro, const HMap* m, u64 key)
+{
+	const u8* s;
+	u64 h = key;
+
+	// FNV-1a for strings, both kinds then mixed so all 64 bits count.
+	if (m->kind == HMAP_KEY_S) {
+		h = 0xcbf29ce484222325;
+		for (s=(pro->img) + key; *s; ++s)
+			h = (h ^ *s) * 0x100000001b3;
+	}
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccd;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53;
+	h ^= h >> 33;
+	return h;
+}
+
+
+static u8
+key_eq(Process* pro, const HMap* m, u64 stored, u64 key)
+{
+	if (m->kind == HMAP_KEY_S)
+		return !strcmp((const char*) (pro->img) + stored, (const char*) (pro->img) + key);
+	return stored == key;
+}
+
+
+// The first group's bytes are mirrored past the end, keep them in step.
+static void
+set_ctrl(u8* ctrl, u64 cap, u64 i, u8 b)
+{
+	ctrl[i] = b;
+	if (i < HMAP_GROUP)
+		ctrl[cap + i] = b;
+}
+
+
+/*
+	Probing:
+		Groups start at the hash's slot and step 1, 2, 3... groups further
+		each time, which with a power of two capacity visits every group
+		before coming back round. A table is never full, so a probe always
+		meets an empty slot in the end.
+*/
+static s64
+find_slot(Process* pro, const HMap* m, u64 key, u64 hash)
+{
+	u8* ctrl = ctrl_bytes(m);
+	u64 mask = m->cap - 1;
+	u64 pos  = (hash >> 7) & mask;
+	u64 step = 0, i;
+	u32 hits;
+
+	if (!m->cap)
+		return -1;
+
+	for (;;) {
+		for (hits=group_match(ctrl + pos, hash & 0x7f); hits; hits &= hits - 1) {
+			i = (pos + __builtin_ctz(hits)) & mask;
+			if (key_eq(pro, m, slot_words(m, i)[0], key))
+				return i;
+		}
+		if (group_match(ctrl + pos, CTRL_EMPTY))
+			return -1;
+		step += HMAP_GROUP;
+		pos = (pos + step) & mask;
+	}
+}
+
+
+static u64
+free_slot(Process* pro, const HMap* m, u64 hash)
+{
+	u8* ctrl = ctrl_bytes(m);
+	u64 mask = m->cap - 1;
+	u64 pos  = (hash >> 7) & mask;
+	u64 step = 0;
+	u32 hits;
+
+	for (;;) {
+		hits = group_free(ctrl + pos);
+		if (hits)
+			return (pos + __builtin_ctz(hits)) & mask;
+		step += HMAP_GROUP;
+		pos = (pos + step) & mask;
+	}
+}
+
+
+static void
+insert_slot(Process* pro, HMap* m, u64 key, u64 value, u64 hash)
+{
+	u64 i = free_slot(pro, m, hash);
+
+	if (ctrl_bytes(m)[i] == CTRL_DELETED)
+		--m->tombs;
+	set_ctrl(ctrl_bytes(m), m->cap, i, hash & 0x7f);
+	slot_words(m, i)[0] = key;
+	slot_words(m, i)[1] = value;
+	++m->len;
+}
+
+
+// Moves every key into a fresh table of cap slots, -1 if the heap is full.
+static s64
+rebuild(Process* pro, HMap* m, u64 cap)
+{
+	HMap old = *m;
+	u64 table = heap_alloc(pro, table_size(cap));
+	u64 i;
+
+	if (!table)
+		return -1;
+
+	m->table = table;
+	m->cap   = cap;
+	m->len   = 0;
+	m->tombs = 0;
+	memset(ctrl_bytes(m), CTRL_EMPTY, cap + HMAP_GROUP);
+
+	for (i=0; i < old.cap; ++i)
+		if (!(ctrl_bytes(&old)[i] & 0x80))
+			insert_slot(pro, m, slot_words(&old, i)[0], slot_words(&old, i)[1],
+			            hash_key(pro, m, slot_words(&old, i)[0]));
+
+	heap_free(pro, old.table);
+	return 0;
+}
+
+
+s64
+hmap_new(Process* pro, HMap* m, u64 kind)
+{
+	u64 table;
+
+	if (kind != HMAP_KEY_U && kind != HMAP_KEY_S)
+		return -1;
+
+	table = heap_alloc(pro, table_size(HMAP_MIN_CAP));
+	if (!table)
+		return -1;
+	if (m->table)
+		hmap_free(pro, m);
+
+	m->kind  = kind;
+	m->len   = 0;
+	m->cap   = HMAP_MIN_CAP;
+	m->tombs = 0;
+	m->table = table;
+	memset(ctrl_bytes(m), CTRL_EMPTY, HMAP_MIN_CAP + HMAP_GROUP);
+	return 0;
+}
+
+
+s64
+hmap_put(Process* pro, HMap* m, u64 key, u64 value)
+{
+	u64 hash = hash_key(pro, m, key);
+	u64 len;
+	s64 i = find_slot(pro, m, key, hash);
+
+	if (!m->cap && hmap_new(pro, m, m->kind) < 0)
+		return -1;
+
+	if (i >= 0) {
+		slot_words(m, i)[1] = value;
+		return 0;
+	}
+
+	// String keys are copied in before anything can fail past undoing.
+	if (m->kind == HMAP_KEY_S) {
+		len = strlen((const char*) (pro->img) + key) + 1;
+		i = heap_alloc(pro, len);
+		if (!i)
+			return -1;
+		memcpy((pro->img) + i, (pro->img) + key, len);
+		key = i;
+	}
+
+	if ((m->len + m->tombs + 1) * 8 > m->cap * 7) {
+		if (rebuild(pro, m, ((m->len + 1) * 16 > m->cap * 7) ? m->cap * 2 : m->cap) < 0) {
+			if (m->kind == HMAP_KEY_S)
+				heap_free(pro, key);
+			return -1;
+		}
+	}
+
+	insert_slot(pro, m, key, value, hash);
+	return 0;
+}
+
+
+u8
+hmap_get(Process* pro, HMap* m, u64 key, u64* value)
+{
+	s64 i = find_slot(pro, m, key, hash_key(pro, m, key));
+
+	if (i < 0)
+		return FALSE;
+	*value = slot_words(m, i)[1];
+	return TRUE;
+}
+
+
+u8
+hmap_del(Process* pro, HMap* m, u64 key)
+{
+	s64 i = find_slot(pro, m, key, hash_key(pro, m, key));
+
+	if (i < 0)
+		return FALSE;
+
+	if (m->kind == HMAP_KEY_S)
+		heap_free(pro, slot_words(m, i)[0]);
+	set_ctrl(ctrl_bytes(m), m->cap, i, CTRL_DELETED);
+	--m->len;
+	++m->tombs;
+	return TRUE;
+}
+
+
+/*
+	Next:
+		Finds the first key at or after slot cursor, returning the cursor
+		to pass next time, or 0 once there are no more. Start from 0.
+		A put between calls that rebuilds the table reorders its keys.
+*/
+u64
+hmap_next(Process* pro, HMap* m, u64 cursor, u64* key, u64* value)
+{
+	u8* ctrl = ctrl_bytes(m);
+	u64 i;
+	u32 full;
+
+	for (i=cursor; i < m->cap; i += HMAP_GROUP) {
+		full = ~group_free(ctrl + i) & 0xffff;
+		if (full) {
+			i += __builtin_ctz(full);
+			if (i >= m->cap)
+				break;
+			*key   = slot_words(m, i)[0];
+			*value = slot_words(m, i)[1];
+			return i + 1;
+		}
+	}
+	return 0;
+}
+
+
+void
+hmap_free(Process* pro, HMap* m)
+{
+	u64 i;
+
+	if (m->kind == HMAP_KEY_S)
+		for (i=0; i < m->cap; ++i)
+			if (!(ctrl_bytes(m)[i] & 0x80))
+				heap_free(pro, slot_words(m, i)[0]);
+
+	heap_free(pro, m->table);
+	memset(m, 0, sizeof(HMap));
+}
@@ -0,0 +1,56 @@
+#ifndef hmap_h
+#define hmap_h
+
+#include "tyson.h"
+
+// Key kinds, HMAP_NEW's second arg.
+#define HMAP_KEY_U  (0)
+#define HMAP_KEY_S  (1)
+
+// Control bytes per probe group, one SSE2 compare.
+#define HMAP_GROUP  (16)
+
+/*
+	Hash Map:
+		Five words anywhere in the image describing an open-addressing
+		map whose table lives in the process heap, laid out after
+		Google's Swiss tables. A table is cap control bytes, one per slot,
+		then cap key/value word pairs. A control byte is empty, deleted or
+		the top 7 bits of the key's hash, so a probe compares a whole
+		group of 16 against the hash at once and only looks at the keys
+		whose bits match, stopping at the first group with an empty slot.
+		The first group's bytes are copied past the end so a group can
+		start at any slot.
+
+		A zeroed descriptor is an empty map of u64 keys, given a table by
+		its first put. hmap_new frees whatever map the descriptor already
+		holds once the new table is had, so it must be zeroed or a map's,
+		and returns -1 for a kind that isn't HMAP_KEY_U or HMAP_KEY_S.
+
+		Keys are u64s, or for HMAP_KEY_S the img-relative offset of a
+		NUL-terminated string, which the map copies into the heap when
+		the key is first put and frees when it's deleted. Keys handed back
+		by hmap_next are the copies.
+
+		A table grows by doubling once more than 7/8 full, tombstones
+		counted, reinserting into a new block and freeing the old for the
+		heap to reuse. One crowded with tombstones rather than keys is
+		rebuilt at the same size. Functions that allocate return -1 if
+		the heap is full, leaving the map as it was.
+*/
+typedef struct {
+	u64 kind;
+	u64 len;
+	u64 cap;
+	u64 tombs;
+	u64 table;
+} __attribute__((packed)) HMap;
+
+s64 hmap_new(Process*, HMap*, u64);
+s64 hmap_put(Process*, HMap*, u64, u64);
+u8  hmap_get(Process*, HMap*, u64, u64*);
+u8  hmap_del(Process*, HMap*, u64);
+u64 hmap_next(Process*, HMap*, u64, u64*, u64*);
+void hmap_free(Process*, HMap*);
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef libtyson_h
+#define libtyson_h
+
+#include <stdint.h>
+
+/*
+	libtyson:
+		Embedding API for the tyson VM. Build the VM sources with
+		-DTYSON_LIB to leave out main() and the interactive debugger.
+
+		Each VMContext is an independent VM with its own registers, stacks
+		and loaded image, and the library keeps no global mutable state, so
+		a host may run any number of contexts at once, one thread per
+		context at a time.
+
+	Usage:
+		VMContext* vm = ty_create();
+		if (ty_load_path(vm, "prog.tpx", argc, argv) == TY_OK)
+			ty_run(vm);
+		ty_destroy(vm);
+*/
+
+typedef struct VMContext VMContext;
+
+// ty_profile flags.
+#define TY_PROF_OFF     0
+#define TY_PROF_COUNTS  1
+#define TY_PROF_CYCLES  2
+#define TY_PROF_PERF    4  // cycles and hardware counters, see perfctr.h.
+
+// Results of ty_run, ty_step and the loaders.
+#define TY_OK       0
+#define TY_DIED     0
+#define TY_STEPPED  1
+#define TY_RETURNED 2
+#define TY_ERROR   (-1)
+
+/*
+	Registers:
+		A snapshot of a context's registers. Pointers are given as offsets,
+		ip, tdx, lp_cont and lp_stop from the start of the process image,
+		sp in bytes from the base of the work stack and rp as the number of
+		return addresses on the return stack. top is the word on top of the
+		work stack.
+*/
+typedef struct {
+	uint64_t ip;
+	uint64_t sp;
+	uint64_t rp;
+	uint64_t tdx;
+	uint64_t lp_cont;
+	uint64_t lp_stop;
+	uint64_t lp_count;
+	uint64_t top;
+} VMRegisters;
+
+/*
+	Usage:
+		How much of each of its bounds the context's process has used
+		since it was loaded, beside the bounds themselves. Stack figures
+		are bytes, return stack ones return addresses and heap ones bytes
+		of whole allocator blocks. The stack peak is only exact for runs
+		made with ty_track_depth on or while profiling, stack_approx is 1
+		when it's a lower bound, see Usage in tyson.h.
+*/
+typedef struct {
+	uint64_t stack_peak;
+	uint64_t stack_size;
+	uint64_t rstack_peak;
+	uint64_t rstack_size;
+	uint64_t heap_allocs;
+	uint64_t heap_allocated;
+	uint64_t heap_live;
+	uint64_t heap_peak;
+	uint64_t heap_size;
+	uint64_t stack_approx;
+} VMUsage;
+
+/*
+	Native Function:
+		Called by NCALL index nargs nrets. win points at the deepest of the
+		nargs words on top of the work stack, and the function writes its
+		nrets results back starting at win[0], which the stack is left
+		holding in place of the args. img is the process image, so any
+		img-relative address taken from the stack is at img + address.
+		data is whatever was given to ty_register_native.
+*/
+typedef void (*VMNativeFunc)(uint64_t* win, uint8_t* img, void* data);
+
+/*
+	Output Function:
+		Takes a context's SHOW_* output in place of its output descriptor,
+		size bytes at a time, whenever the context's buffer is flushed.
+*/
+typedef void (*VMOutputFunc)(const uint8_t* bytes, uint64_t size, void* data);
+
+VMContext* ty_create(void);
+void       ty_destroy(VMContext*);
+int        ty_load_path(VMContext*, const char*, int, char**);
+int        ty_load_mem(VMContext*, const uint8_t*, uint64_t, int, char**);
+int        ty_run(VMContext*);
+int        ty_step(VMContext*);
+void       ty_registers(VMContext*, VMRegisters*);
+void       ty_usage(VMContext*, VMUsage*);
+void       ty_track_depth(VMContext*, int);
+uint8_t*   ty_image(VMContext*, uint64_t*);
+int64_t    ty_export(VMContext*, const char*);
+int        ty_call(VMContext*, uint64_t, const uint64_t*, uint64_t, uint64_t*);
+int        ty_register_native(VMContext*, uint64_t, VMNativeFunc, void*);
+void       ty_output_fd(VMContext*, int);
+void       ty_output_func(VMContext*, VMOutputFunc, void*);
+void       ty_flush(VMContext*);
+int        ty_profile(VMContext*, int);
+void       ty_profile_dump(VMContext*);
+int        ty_sample(VMContext*, uint64_t);
+int        ty_sample_write(VMContext*, const char*);
+int        ty_sample_write_folded(VMContext*, const char*);
+int        ty_trace(VMContext*, uint64_t);
+int        ty_trace_write(VMContext*, const char*);
+
+#endif
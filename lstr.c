@@ -0,0 +1,142 @@
+#include <string.h>
+
+#include "tyson.h"
+#include "heap.h"
+#include "lstr.h"
+
+#define ls_bytes(s) \
+	((pro->img) + (s)->data)
+
+
+// Makes s an empty string owning room for cap bytes, -1 if the heap is full.
+s64
+ls_new(Process* pro, LStr* s, u64 cap)
+{
+	u64 offs = heap_alloc(pro, cap ? cap : 1);
+
+	if (!offs)
+		return -1;
+
+	s->data = offs;
+	s->len  = 0;
+	s->cap  = heap_capacity(pro, offs);
+	return 0;
+}
+
+
+// Makes s a copy of the NUL-terminated string at str.
+s64
+ls_from(Process* pro, LStr* s, const u8* str)
+{
+	u64 len = strlen((const char*) str);
+
+	if (ls_new(pro, s, len) < 0)
+		return -1;
+
+	memcpy(ls_bytes(s), str, len);
+	s->len = len;
+	return 0;
+}
+
+
+// Copies s out to dst NUL-terminated, dst must have room for len+1 bytes.
+void
+ls_toc(Process* pro, u8* dst, const LStr* s)
+{
+	memmove(dst, ls_bytes(s), s->len);
+	dst[s->len] = 0;
+}
+
+
+/*
+	Concatenate:
+		Appends src to dst. When dst is out of room, or is a view, its
+		bytes move to a block at least twice the size, so n appends cost
+		O(n) copying all told. src may be a view into dst itself, the old
+		block is only freed once it's been copied from.
+*/
+s64
+ls_cat(Process* pro, LStr* dst, const LStr* src)
+{
+	u64 need = dst->len + src->len;
+	u64 want, offs;
+
+	if (dst->cap && need <= dst->cap) {
+		memmove(ls_bytes(dst) + dst->len, ls_bytes(src), src->len);
+		dst->len = need;
+		return 0;
+	}
+
+	want = dst->cap * 2;
+	if (want < need)
+		want = need;
+
+	offs = heap_alloc(pro, want);
+	if (!offs)
+		return -1;
+
+	memcpy((pro->img) + offs, ls_bytes(dst), dst->len);
+	memcpy((pro->img) + offs + dst->len, ls_bytes(src), src->len);
+	if (dst->cap)
+		heap_free(pro, dst->data);
+
+	dst->data = offs;
+	dst->len  = need;
+	dst->cap  = heap_capacity(pro, offs);
+	return 0;
+}
+
+
+// Orders a before b as -1, equal 0 and after 1, bytewise then shortest first.
+s64
+ls_cmp(Process* pro, const LStr* a, const LStr* b)
+{
+	u64 len = (a->len < b->len) ? a->len : b->len;
+	int c = memcmp(ls_bytes(a), ls_bytes(b), len);
+
+	if (c)
+		return (c < 0) ? -1 : 1;
+	if (a->len == b->len)
+		return 0;
+	return (a->len < b->len) ? -1 : 1;
+}
+
+
+// Equality, strings of different lengths are never compared byte by byte.
+u8
+ls_eq(Process* pro, const LStr* a, const LStr* b)
+{
+	if (a->len != b->len)
+		return FALSE;
+	if (a->data == b->data)
+		return TRUE;
+	return memcmp(ls_bytes(a), ls_bytes(b), a->len) == 0;
+}
+
+
+// Makes dst a view of len bytes of src from start, clamped to src's end.
+void
+ls_sub(LStr* dst, const LStr* src, u64 start, u64 len)
+{
+	if (start > src->len)
+		start = src->len;
+	if (len > src->len - start)
+		len = src->len - start;
+
+	dst->data = src->data + start;
+	dst->len  = len;
+	dst->cap  = 0;
+}
+
+
+// Gives back an owned string's block, leaving the empty string.
+void
+ls_free(Process* pro, LStr* s)
+{
+	if (s->cap)
+		heap_free(pro, s->data);
+
+	s->data = 0;
+	s->len  = 0;
+	s->cap  = 0;
+}
@@ -0,0 +1,33 @@
+#ifndef lstr_h
+#define lstr_h
+
+#include "tyson.h"
+
+/*
+	Length-Prefixed String:
+		Three words anywhere in the image, the img-relative offset of the
+		bytes, their length and the capacity of the heap block holding
+		them. A capacity of 0 marks a view, bytes the string doesn't own,
+		whether a substring of another string or nothing at all, a zeroed
+		descriptor being the empty string. Owned bytes come from the heap
+		allocator and aren't NUL-terminated.
+
+		Views share their bytes, they go stale once the string they look
+		into grows or is freed.
+*/
+typedef struct {
+	u64 data;
+	u64 len;
+	u64 cap;
+} __attribute__((packed)) LStr;
+
+s64 ls_new(Process*, LStr*, u64);
+s64 ls_from(Process*, LStr*, const u8*);
+void ls_toc(Process*, u8*, const LStr*);
+s64 ls_cat(Process*, LStr*, const LStr*);
+s64 ls_cmp(Process*, const LStr*, const LStr*);
+u8  ls_eq(Process*, const LStr*, const LStr*);
+void ls_sub(LStr*, const LStr*, u64, u64);
+void ls_free(Process*, LStr*);
+
+#endif
@@ -0,0 +1,106 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "tyson.h"
+#include "native.h"
+
+/*
+	Builtin Natives:
+		The functions every context's native table starts out with. Each
+		takes its args from the NCALL window and writes its result back to
+		win[0], none of them allocate. Arg counts and types are noted
+		beside each as args -> results.
+*/
+
+#define r64_arg(n) \
+	(*((r64*) (win + (n))))
+
+// r64 -> r64
+static void nat_sqrt(u64* win, u8* img, void* data)  { r64_arg(0) = sqrt(r64_arg(0)); }
+static void nat_exp(u64* win, u8* img, void* data)   { r64_arg(0) = exp(r64_arg(0)); }
+static void nat_log(u64* win, u8* img, void* data)   { r64_arg(0) = log(r64_arg(0)); }
+static void nat_sin(u64* win, u8* img, void* data)   { r64_arg(0) = sin(r64_arg(0)); }
+static void nat_cos(u64* win, u8* img, void* data)   { r64_arg(0) = cos(r64_arg(0)); }
+static void nat_floor(u64* win, u8* img, void* data) { r64_arg(0) = floor(r64_arg(0)); }
+static void nat_ceil(u64* win, u8* img, void* data)  { r64_arg(0) = ceil(r64_arg(0)); }
+static void nat_fabs(u64* win, u8* img, void* data)  { r64_arg(0) = fabs(r64_arg(0)); }
+
+// r64 base, r64 exponent -> r64
+static void nat_pow(u64* win, u8* img, void* data)   { r64_arg(0) = pow(r64_arg(0), r64_arg(1)); }
+
+
+// FNV-1a over len bytes.
+static u64
+fnv1a(const u8* bp, u64 len)
+{
+	u64 h = 14695981039346656037ULL;
+
+	while (len--) {
+		h ^= *bp++;
+		h *= 1099511628211ULL;
+	}
+
+	return h;
+}
+
+// u64 address of 0-terminated string -> u64 hash
+static void
+nat_hash_s(u64* win, u8* img, void* data)
+{
+	u8* bp = img + win[0];
+	win[0] = fnv1a(bp, strlen((char*) bp));
+}
+
+// u64 address of byte-table, u64 length -> u64 hash
+static void
+nat_hash_t(u64* win, u8* img, void* data)
+{
+	win[0] = fnv1a(img + win[0], win[1]);
+}
+
+// u64 -> u64 hash, the splitmix64 finaliser.
+static void
+nat_hash_u(u64* win, u8* img, void* data)
+{
+	u64 h = win[0];
+
+	h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+	win[0] = h ^ (h >> 31);
+}
+
+// u64 address of 0-terminated decimal string -> u64, s64 or r64.
+static void nat_str2u(u64* win, u8* img, void* data) { win[0] = strtoull((char*) (img + win[0]), 0, 10); }
+static void nat_str2i(u64* win, u8* img, void* data) { win[0] = (u64) strtoll((char*) (img + win[0]), 0, 10); }
+static void nat_str2r(u64* win, u8* img, void* data) { r64_arg(0) = strtod((char*) (img + win[0]), 0); }
+
+
+static const VMNativeFunc builtins[NATIVE_BUILTINS] = {nat_sqrt,
+                                                       nat_pow,
+                                                       nat_exp,
+                                                       nat_log,
+                                                       nat_sin,
+                                                       nat_cos,
+                                                       nat_floor,
+                                                       nat_ceil,
+                                                       nat_fabs,
+                                                       nat_hash_s,
+                                                       nat_hash_t,
+                                                       nat_hash_u,
+                                                       nat_str2u,
+                                                       nat_str2i,
+                                                       nat_str2r};
+
+
+// Fills in a native table, builtins first and the rest of the slots empty.
+void
+load_builtin_natives(Native* natives)
+{
+	u64 i;
+
+	for (i=0; i < NATIVE_TABLE_SIZE; ++i) {
+		natives[i].func = (i < NATIVE_BUILTINS) ? builtins[i] : 0;
+		natives[i].data = 0;
+	}
+}
@@ -0,0 +1,27 @@
+#ifndef native_h
+#define native_h
+
+#include "tyson.h"
+
+// Builtin native table indices, see native.c.
+#define NAT_SQRT      0
+#define NAT_POW       1
+#define NAT_EXP       2
+#define NAT_LOG       3
+#define NAT_SIN       4
+#define NAT_COS       5
+#define NAT_FLOOR     6
+#define NAT_CEIL      7
+#define NAT_FABS      8
+#define NAT_HASH_S    9
+#define NAT_HASH_T   10
+#define NAT_HASH_U   11
+#define NAT_STR2U    12
+#define NAT_STR2I    13
+#define NAT_STR2R    14
+
+#define NATIVE_BUILTINS 15
+
+void load_builtin_natives(Native*);
+
+#endif
@@ -6,9 +6,247 @@
 #include "tyson.h"
 
 
-char* opcode_strmap[OPCOUNT] = {"die",
-                                 "nop",
-								     "jmp"};
+const char* const opcode_strmap[OPCOUNT] = {"die",
+                                            "nop",
+                                            "jmp",
+                                            "call",
+                                            "ret",
+                                            "swch",
+                                            "jeq_b",
+                                            "jneq_b",
+                                            "jeq_w",
+                                            "jneq_w",
+                                            "jgeq_u",
+                                            "jleq_u",
+                                            "jgt_u",
+                                            "jlt_u",
+                                            "jgeq_i",
+                                            "jleq_i",
+                                            "jgt_i",
+                                            "jlt_i",
+                                            "jgeq_r",
+                                            "jleq_r",
+                                            "jgt_r",
+                                            "jlt_r",
+                                            "jmp_c1",
+                                            "jmp_c2",
+                                            "jmp_c3",
+                                            "jmp_c4",
+                                            "set_c1",
+                                            "set_c2",
+                                            "set_c3",
+                                            "set_c4",
+                                            "eq",
+                                            "neq",
+                                            "and",
+                                            "not",
+                                            "or",
+                                            "xor",
+                                            "lsh",
+                                            "rsh",
+                                            "inc_b",
+                                            "inc_u",
+                                            "inc_i",
+                                            "dec_b",
+                                            "dec_u",
+                                            "dec_i",
+                                            "add_b",
+                                            "add_u",
+                                            "add_i",
+                                            "add_r",
+                                            "sub_b",
+                                            "sub_u",
+                                            "sub_i",
+                                            "sub_r",
+                                            "mul_b",
+                                            "mul_u",
+                                            "mul_i",
+                                            "mul_r",
+                                            "div_b",
+                                            "div_u",
+                                            "div_i",
+                                            "div_r",
+                                            "mod_b",
+                                            "mod_u",
+                                            "mod_i",
+                                            "b2u",
+                                            "b2i",
+                                            "b2r",
+                                            "u2b",
+                                            "u2i",
+                                            "u2r",
+                                            "i2b",
+                                            "i2u",
+                                            "i2r",
+                                            "r2b",
+                                            "r2u",
+                                            "r2i",
+                                            "lstart",
+                                            "ltest",
+                                            "lcont",
+                                            "lstop",
+                                            "breakpoint",
+                                            "put_b",
+                                            "put_nb",
+                                            "put_hw",
+                                            "put_w",
+                                            "put_nw",
+                                            "put_dw",
+                                            "put_qw",
+                                            "put_s",
+                                            "cpy_b",
+                                            "cpy_nb",
+                                            "cpy_hw",
+                                            "cpy_w",
+                                            "cpy_nw",
+                                            "cpy_dw",
+                                            "cpy_qw",
+                                            "cpy_s",
+                                            "xch_b",
+                                            "xch_nb",
+                                            "xch_hw",
+                                            "xch_w",
+                                            "xch_nw",
+                                            "xch_dw",
+                                            "xch_qw",
+                                            "xch_s",
+                                            "str_cmp",
+                                            "str_ncmp",
+                                            "jmp_str_cmp",
+                                            "jmp_str_ncmp",
+                                            "str_chr",
+                                            "str_cspn",
+                                            "str_str",
+                                            "str_cat",
+                                            "str_ncat",
+                                            "str_len",
+                                            "rstk_up",
+                                            "rstk_dwn",
+                                            "rstk_rst",
+                                            "put_b_fs",
+                                            "put_w_fs",
+                                            "cpy_b_fs",
+                                            "cpy_w_fs",
+                                            "xch_b_fs",
+                                            "xch_w_fs",
+                                            "set_tdx_fc",
+                                            "set_tdx_fh",
+                                            "set_tdx_fs",
+                                            "t_fd_putb",
+                                            "t_bk_putb",
+                                            "t_fd_putw",
+                                            "t_bk_putw",
+                                            "t_fd_cpyb",
+                                            "t_bk_cpyb",
+                                            "t_fd_cpyw",
+                                            "t_bk_cpyw",
+                                            "t_fd_popb",
+                                            "t_bk_popb",
+                                            "t_fd_popw",
+                                            "t_bk_popw",
+                                            "t_fd_pshb",
+                                            "t_bk_pshb",
+                                            "t_fd_pshw",
+                                            "t_bk_pshw",
+                                            "stk_spoffs",
+                                            "stk_save",
+                                            "stk_load",
+                                            "stk_up",
+                                            "stk_dwn",
+                                            "stk_rst",
+                                            "stk_clr",
+                                            "stk_set",
+                                            "stk_setn",
+                                            "stk_setc",
+                                            "stk_setcn",
+                                            "stk_cpy",
+                                            "stk_cpyn",
+                                            "stk_xch",
+                                            "stk_xchn",
+                                            "stk_hxch",
+                                            "stk_hxchn",
+                                            "stk_mov",
+                                            "stk_movn",
+                                            "stk_del",
+                                            "stk_deln",
+                                            "stk_get",
+                                            "stk_getn",
+                                            "stk_ins",
+                                            "stk_insn",
+                                            "stk_2top",
+                                            "stk_tt_dup",
+                                            "stk_xt_dup",
+                                            "stk_tx_dup",
+                                            "stk_top_dup",
+                                            "stk_top_dup2",
+                                            "stk_dup",
+                                            "stk_tapsh",
+                                            "stk_psh",
+                                            "stk_pshc",
+                                            "stk_psh0",
+                                            "stk_psh1",
+                                            "stk_psh2",
+                                            "stk_ovwr",
+                                            "stk_stor",
+                                            "stk_pop",
+                                            "stk_xcht",
+                                            "stk_gcol",
+                                            "openf",
+                                            "ncall",
+                                            "closef",
+                                            "readf",
+                                            "writef",
+                                            "seekf",
+                                            "readh",
+                                            "writeh",
+                                            "areadh",
+                                            "awriteh",
+                                            "await",
+                                            "mapf",
+                                            "unmapf",
+                                            "flush",
+                                            "rsv_sys15",
+                                            "show_top_b",
+                                            "show_top_u",
+                                            "show_top_i",
+                                            "show_top_r",
+                                            "show_mem_b",
+                                            "show_mem_u",
+                                            "show_mem_i",
+                                            "show_mem_r",
+                                            "show_mem_s",
+                                            "tdx_b_up",
+                                            "tdx_b_dwn",
+                                            "tdx_w_up",
+                                            "tdx_w_dwn",
+                                            "plstart",
+                                            "ls_new",
+                                            "ls_from",
+                                            "ls_toc",
+                                            "ls_len",
+                                            "ls_cat",
+                                            "ls_cmp",
+                                            "jmp_ls_eq",
+                                            "ls_sub",
+                                            "ls_free",
+                                            "red_sum",
+                                            "red_min",
+                                            "red_max",
+                                            "red_dot",
+                                            "t_fd_cpynw",
+                                            "t_fd_fillnw",
+                                            "t_cmpnw",
+                                            "t_diffnw",
+                                            "hmap_new",
+                                            "hmap_put",
+                                            "hmap_get",
+                                            "hmap_del",
+                                            "hmap_iter",
+                                            "hmap_len",
+                                            "hmap_free",
+                                            "sort",
+                                            "sort_kv",
+                                            "prof_dump"};
 
 /*
 	Lookup Opcode:
@@ -77,5 +315,5 @@ is_mneumonic(const char* str)
 u8
 is_opcode(const u64 opcode)
 {
-	return ((opcode >= 0) && (opcode <= OPCOUNT));
+	return (opcode < OPCOUNT);
 }
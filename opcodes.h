@@ -3,7 +3,7 @@
 
 #include "tyson.h"
 
-#define OPCOUNT      213
+#define OPCOUNT      241
 
 #define DIE            0
 #define NOP            1
@@ -204,19 +204,19 @@
 #define STK_GCOL     184
 
 #define OPENF        185
-#define RSV_SYS2     186
-#define RSV_SYS3     187
-#define RSV_SYS4     188
-#define RSV_SYS5     189
-#define RSV_SYS6     190
-#define RSV_SYS7     191
-#define RSV_SYS8     192
-#define RSV_SYS9     193
-#define RSV_SYS10    194
-#define RSV_SYS11    195
-#define RSV_SYS12    196
-#define RSV_SYS13    197
-#define RSV_SYS14    198
+#define NCALL        186
+#define CLOSEF       187
+#define READF        188
+#define WRITEF       189
+#define SEEKF        190
+#define READH        191
+#define WRITEH       192
+#define AREADH       193
+#define AWRITEH      194
+#define AWAIT        195
+#define MAPF         196
+#define UNMAPF       197
+#define FLUSH        198
 #define RSV_SYS15    199
 
 #define SHOW_TOP_B   200
@@ -234,9 +234,38 @@
 #define TDX_W_UP     211
 #define TDX_W_DWN    212
 
+#define PLSTART      213
+
+#define LS_NEW       214
+#define LS_FROM      215
+#define LS_TOC       216
+#define LS_LEN       217
+#define LS_CAT       218
+#define LS_CMP       219
+#define JMP_LS_EQ    220
+#define LS_SUB       221
+#define LS_FREE      222
+#define RED_SUM      223
+#define RED_MIN      224
+#define RED_MAX      225
+#define RED_DOT      226
+#define T_FD_CPYNW   227
+#define T_FD_FILLNW  228
+#define T_CMPNW      229
+#define T_DIFFNW     230
+#define HMAP_NEW     231
+#define HMAP_PUT     232
+#define HMAP_GET     233
+#define HMAP_DEL     234
+#define HMAP_ITER    235
+#define HMAP_LEN     236
+#define HMAP_FREE    237
+#define SORT         238
+#define SORT_KV      239
+#define PROF_DUMP    240
 
 #define build_optable()                  			  \
-	static void* optable[OPCOUNT]= {&&die,            \
+	static void* const optable[OPCOUNT]= {&&die,            \
 		                            &&nop,            \
 		                            &&jmp,            \
                                     &&call,           \
@@ -422,19 +451,19 @@
 									&&stk_xcht, \
 									&&stk_gcol, \
 									&&openf, \
-									&&rsv_sys2, \
-									&&rsv_sys3, \
-									&&rsv_sys4, \
-									&&rsv_sys5, \
-									&&rsv_sys6, \
-									&&rsv_sys7, \
-									&&rsv_sys8, \
-									&&rsv_sys9, \
-									&&rsv_sys10,\
-									&&rsv_sys11, \
-									&&rsv_sys12, \
-									&&rsv_sys13, \
-									&&rsv_sys14, \
+									&&ncall, \
+									&&closef, \
+									&&readf, \
+									&&writef, \
+									&&seekf, \
+									&&readh, \
+									&&writeh, \
+									&&areadh, \
+									&&awriteh,\
+									&&await, \
+									&&mapf, \
+									&&unmapf, \
+									&&flush, \
 									&&rsv_sys15,\
 									&&show_top_b, \
 									&&show_top_u, \
@@ -448,11 +477,39 @@
                                     &&tdx_b_up,   \
                                     &&tdx_b_dwn,  \
                                     &&tdx_w_up,   \
-                                    &&tdx_w_dwn}
+                                    &&tdx_w_dwn,  \
+                                    &&plstart, \
+                                    &&ls_new, \
+                                    &&ls_from, \
+                                    &&ls_toc, \
+                                    &&ls_len, \
+                                    &&ls_cat, \
+                                    &&ls_cmp, \
+                                    &&jmp_ls_eq, \
+                                    &&ls_sub, \
+                                    &&ls_free, \
+                                    &&red_sum, \
+                                    &&red_min, \
+                                    &&red_max, \
+                                    &&red_dot, \
+                                    &&t_fd_cpynw, \
+                                    &&t_fd_fillnw, \
+                                    &&t_cmpnw, \
+                                    &&t_diffnw, \
+                                    &&hmap_new, \
+                                    &&hmap_put, \
+                                    &&hmap_get, \
+                                    &&hmap_del, \
+                                    &&hmap_iter, \
+                                    &&hmap_len, \
+                                    &&hmap_free, \
+                                    &&sort, \
+                                    &&sort_kv, \
+                                    &&prof_dump}
 
 
 
-char* opcode_strmap[OPCOUNT];
+extern const char* const opcode_strmap[OPCOUNT];
 
 u8  lookup_opcode(const u64, char*);
 s64 lookup_mneumonic(const char*);
@@ -0,0 +1,183 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "tyson.h"
+#include "output.h"
+
+// Longest u64 in decimal plus a sign.
+#define NUM_MAXLEN 21
+
+
+void
+out_init(OutBuf* ob)
+{
+	ob->len  = 0;
+	ob->fd   = STDOUT_FILENO;
+	ob->func = 0;
+	ob->data = 0;
+}
+
+
+static void
+out_write(OutBuf* ob, const u8* bp, u64 n)
+{
+	ssize_t put;
+
+	if (ob->func) {
+		ob->func(bp, n, ob->data);
+		return;
+	}
+
+	// Anything still in stdio's buffer was printed first, keep it first.
+	if (ob->fd == STDOUT_FILENO)
+		fflush(stdout);
+
+	while (n) {
+		put = write(ob->fd, bp, n);
+		if (put > 0) {
+			bp += put;
+			n  -= (u64) put;
+		} else if (put < 0 && errno == EINTR) {
+			continue;
+		} else {
+			return;
+		}
+	}
+}
+
+
+void
+out_flush(OutBuf* ob)
+{
+	if (ob->len)
+		out_write(ob, ob->buf, ob->len);
+	ob->len = 0;
+}
+
+
+void
+out_bytes(OutBuf* ob, const u8* bp, u64 n)
+{
+	if ((ob->len + n) > OUTPUT_BUFFER_SIZE) {
+		out_flush(ob);
+		if (n >= OUTPUT_BUFFER_SIZE) {
+			out_write(ob, bp, n);
+			return;
+		}
+	}
+
+	memcpy(ob->buf + ob->len, bp, n);
+	ob->len += n;
+}
+
+
+void
+out_str(OutBuf* ob, const char* s)
+{
+	out_bytes(ob, (const u8*) s, strlen(s));
+}
+
+
+// Writes n's digits ending just before end, returns where they start.
+static u8*
+format_u64(u8* end, u64 n)
+{
+	do {
+		*--end = (u8) ('0' + (n % 10));
+		n /= 10;
+	} while (n);
+
+	return end;
+}
+
+
+void
+out_u64(OutBuf* ob, u64 n)
+{
+	u8  num[NUM_MAXLEN];
+	u8* bp = format_u64(num + NUM_MAXLEN, n);
+
+	out_bytes(ob, bp, (u64) ((num + NUM_MAXLEN) - bp));
+}
+
+
+void
+out_s64(OutBuf* ob, s64 n)
+{
+	u8  num[NUM_MAXLEN];
+	u8* bp;
+
+	// Negating through u64 keeps the most negative s64 right.
+	if (n < 0) {
+		bp = format_u64(num + NUM_MAXLEN, -((u64) n));
+		*--bp = '-';
+	} else {
+		bp = format_u64(num + NUM_MAXLEN, (u64) n);
+	}
+
+	out_bytes(ob, bp, (u64) ((num + NUM_MAXLEN) - bp));
+}
+
+
+/*
+	Format Real:
+		Prints x as %f does, six places rounded to nearest. Values too big
+		to scale into a u64, nan and inf, and those that land so near a
+		half in the last place that the scaling could round them the wrong
+		way, are left to snprintf.
+*/
+void
+out_r64(OutBuf* ob, r64 x)
+{
+	u8  num[48];
+	u8* end = num + sizeof(num);
+	u8* bp;
+	r64 whole, scaled, half;
+	u64 frac, i;
+	int len;
+
+	if (isfinite(x) && fabs(x) < 1e12) {
+		whole  = floor(fabs(x));
+		scaled = (fabs(x) - whole) * 1e6;
+		half   = scaled - floor(scaled);
+		if (fabs(half - 0.5) > 1e-6)
+			goto fast;
+	}
+
+	len = snprintf((char*) num, sizeof(num), "%f", (double) x);
+	out_bytes(ob, num, (len > 0) ? (u64) len : 0);
+	return;
+
+fast:
+	frac = (u64) (scaled + 0.5);
+	if (frac == 1000000) {
+		frac = 0;
+		whole += 1.0;
+	}
+
+	bp = end;
+	for (i=0; i < 6; ++i) {
+		*--bp = (u8) ('0' + (frac % 10));
+		frac /= 10;
+	}
+	*--bp = '.';
+	bp = format_u64(bp, (u64) whole);
+	if (signbit(x))
+		*--bp = '-';
+
+	out_bytes(ob, bp, (u64) (end - bp));
+}
+
+
+// One DEBUG_MODE trace line, "\n\t<name> executed on cycle <cycle>".
+void
+out_trace(OutBuf* ob, const char* name, u64 cycle)
+{
+	out_bytes(ob, (const u8*) "\n\t", 2);
+	out_str(ob, name);
+	out_bytes(ob, (const u8*) " executed on cycle ", 19);
+	out_u64(ob, cycle);
+}
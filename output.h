@@ -0,0 +1,24 @@
+#ifndef output_h
+#define output_h
+
+#include "tyson.h"
+
+/*
+	Output:
+		Everything a context shows, SHOW_* values and DEBUG_MODE traces, is
+		formatted straight into its OutBuf and only written out when the
+		buffer fills, the process dies, FLUSH runs or the debugger is about
+		to prompt. It goes to the buffer's descriptor, stdout by default,
+		or to the host's output function if one is set.
+*/
+
+void out_init(OutBuf*);
+void out_flush(OutBuf*);
+void out_bytes(OutBuf*, const u8*, u64);
+void out_str(OutBuf*, const char*);
+void out_u64(OutBuf*, u64);
+void out_s64(OutBuf*, s64);
+void out_r64(OutBuf*, r64);
+void out_trace(OutBuf*, const char*, u64);
+
+#endif
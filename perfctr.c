@@ -0,0 +1,117 @@
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+#include "tyson.h"
+#include "perfctr.h"
+
+const char* const perf_event_names[PERF_EVENTS] = {"instructions", "branch-misses", "cache-misses"};
+
+static const u64 perf_configs[PERF_EVENTS] = {PERF_COUNT_HW_INSTRUCTIONS,
+                                              PERF_COUNT_HW_BRANCH_MISSES,
+                                              PERF_COUNT_HW_CACHE_MISSES};
+
+
+/*
+	Open:
+		Opens the counters for the calling thread, closing any it had open
+		for another. Returns how many of the events could be had, 0 when
+		the machine has no pmu to give or perf_event_paranoid forbids it.
+*/
+u64
+perf_open(PerfCounters* pc)
+{
+	struct perf_event_attr attr;
+	pid_t tid = (pid_t) syscall(SYS_gettid);
+	void* page;
+	u64 i;
+
+	if (pc->tid == tid)
+		return pc->count;
+	if (pc->tid)
+		perf_close(pc);
+
+	for (i=0; i < PERF_EVENTS; ++i) {
+		pc->fd[i] = -1;
+		pc->page[i] = 0;
+
+		memset(&attr, 0, sizeof(attr));
+		attr.size   = sizeof(attr);
+		attr.type   = PERF_TYPE_HARDWARE;
+		attr.config = perf_configs[i];
+		attr.exclude_kernel = 1;
+		attr.exclude_hv     = 1;
+		pc->fd[i] = (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+		if (pc->fd[i] < 0)
+			continue;
+
+		// Only the first page is wanted, it says whether and how rdpmc may be used.
+		page = mmap(0, sysconf(_SC_PAGESIZE), PROT_READ, MAP_SHARED, pc->fd[i], 0);
+		if (page != MAP_FAILED)
+			pc->page[i] = (struct perf_event_mmap_page*) page;
+		++pc->count;
+	}
+
+	pc->tid = tid;
+	return pc->count;
+}
+
+
+void
+perf_close(PerfCounters* pc)
+{
+	u64 i;
+
+	if (!pc->tid)
+		return;
+	for (i=0; i < PERF_EVENTS; ++i) {
+		if (pc->page[i])
+			munmap(pc->page[i], sysconf(_SC_PAGESIZE));
+		if (pc->fd[i] >= 0)
+			close(pc->fd[i]);
+		pc->fd[i] = -1;
+		pc->page[i] = 0;
+	}
+	pc->tid = 0;
+	pc->count = 0;
+}
+
+
+// Current value of event i, by the seqlock protocol perf_event.h describes.
+u64
+perf_read(PerfCounters* pc, u64 i)
+{
+	struct perf_event_mmap_page* page = pc->page[i];
+	u64 value = 0;
+
+	#if defined(__x86_64__)
+	u32 seq, index;
+	s64 pmc;
+
+	if (page && page->cap_user_rdpmc) {
+		do {
+			seq = page->lock;
+			__sync_synchronize();
+			index = page->index;
+			value = page->offset;
+			if (index) {
+				pmc = (s64) __rdpmc(index - 1);
+				pmc <<= 64 - page->pmc_width;
+				pmc >>= 64 - page->pmc_width;
+				value += pmc;
+			}
+			__sync_synchronize();
+		} while (page->lock != seq);
+		return value;
+	}
+	#endif
+
+	if (pc->fd[i] < 0 || read(pc->fd[i], &value, sizeof(value)) != sizeof(value))
+		return 0;
+	return value;
+}
@@ -0,0 +1,36 @@
+#ifndef perfctr_h
+#define perfctr_h
+
+#include <sys/types.h>
+#include <linux/perf_event.h>
+
+#include "tyson.h"
+
+// Hardware events counted, in the order the profile keeps them.
+#define PERF_EVENTS        (3)
+#define PERF_INSTRUCTIONS  (0)
+#define PERF_BRANCH_MISSES (1)
+#define PERF_CACHE_MISSES  (2)
+
+extern const char* const perf_event_names[PERF_EVENTS];
+
+/*
+	Perf Counters:
+		Hardware counters from perf_event_open counting user-space events
+		on one thread, the one that called perf_open. Where the kernel
+		lets us they are read with rdpmc through each event's mmapped
+		page, a few dozen cycles, and with read() otherwise. An event the
+		cpu or kernel won't give us is left out, fd -1, and reads as 0.
+*/
+typedef struct {
+	int   fd[PERF_EVENTS];
+	struct perf_event_mmap_page* page[PERF_EVENTS];
+	pid_t tid;   // thread they count for, 0 if none.
+	u64   count; // events opened.
+} PerfCounters;
+
+u64  perf_open(PerfCounters*);
+void perf_close(PerfCounters*);
+u64  perf_read(PerfCounters*, u64);
+
+#endif
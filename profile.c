@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tyson.h"
+#include "opcodes.h"
+#include "output.h"
+#include "profile.h"
+
+
+Profile*
+new_profile(u64 flags)
+{
+	Profile* p = (Profile*) calloc(1, sizeof(Profile));
+
+	if (p)
+		p->flags = flags;
+	return p;
+}
+
+
+void
+free_profile(Profile* p)
+{
+	if (p)
+		perf_close(&p->perf);
+	free(p);
+}
+
+
+// Called as interpret starts, time spent outside it isn't anybody's.
+void
+prof_start(Profile* p)
+{
+	if (p->flags & PROF_PERF)
+		perf_open(&p->perf);
+	p->timing = FALSE;
+}
+
+
+// Called as interpret returns, the last opcode gets the time up to now.
+void
+prof_stop(Profile* p)
+{
+	if (p->timing) {
+		p->cycles[p->op] += prof_clock() - p->mark;
+		if (p->flags & PROF_PERF)
+			prof_events(p);
+	}
+	p->timing = FALSE;
+}
+
+
+// Charges what each counter moved since the last dispatch to the opcode that ran.
+void
+prof_events(Profile* p)
+{
+	u64 now, i;
+
+	for (i=0; i < PERF_EVENTS; ++i) {
+		if (p->perf.fd[i] < 0)
+			continue;
+		now = perf_read(&p->perf, i);
+		if (p->timing)
+			p->events[i][p->op] += now - p->event_mark[i];
+		p->event_mark[i] = now;
+	}
+}
+
+
+void
+prof_merge(Profile* dst, const Profile* src)
+{
+	u64 i, j;
+
+	for (i=0; i < PROF_OPS; ++i) {
+		dst->count[i]  += src->count[i];
+		dst->cycles[i] += src->cycles[i];
+		for (j=0; j < PERF_EVENTS; ++j)
+			dst->events[j][i] += src->events[j][i];
+	}
+}
+
+
+/*
+	Dump:
+		Writes a table of every opcode that ran, most expensive first,
+		by cycles when they're kept and by count otherwise, with each
+		one's share of the total. Hardware counters, when kept, follow as
+		per-op averages: native instructions, branch and cache misses.
+*/
+void
+prof_dump(Profile* p, OutBuf* ob)
+{
+	u8  order[PROF_OPS];
+	u64 total = 0, cycles = 0, n = 0, i, j;
+	u64* key = (p->flags & PROF_CYCLES) ? p->cycles : p->count;
+	char line[256];
+	u8 t;
+
+	for (i=0; i < PROF_OPS; ++i) {
+		total  += p->count[i];
+		cycles += p->cycles[i];
+		if (p->count[i])
+			order[n++] = (u8) i;
+	}
+
+	// Never more than a few hundred, insertion sort does.
+	for (i=1; i < n; ++i) {
+		t = order[i];
+		for (j=i; j > 0 && key[order[j - 1]] < key[t]; --j)
+			order[j] = order[j - 1];
+		order[j] = t;
+	}
+
+	snprintf(line, sizeof(line), "\n\tprofile: %lu instructions", total);
+	out_str(ob, line);
+	if (p->flags & PROF_CYCLES) {
+		snprintf(line, sizeof(line), ", %lu cycles", cycles);
+		out_str(ob, line);
+		out_str(ob, "\n\t  opcode            count      %         cycles      %   cyc/op");
+		if (p->flags & PROF_PERF)
+			out_str(ob, "   ins/op  brmiss/op  cmiss/op");
+	} else {
+		out_str(ob, "\n\t  opcode            count      %");
+	}
+
+	for (i=0; i < n; ++i) {
+		t = order[i];
+		snprintf(line, sizeof(line), "\n\t  %-13s %9lu %6.2f", (t < OPCOUNT) ? opcode_strmap[t] : "?",
+		         p->count[t], 100.0 * p->count[t] / total);
+		out_str(ob, line);
+		if (p->flags & PROF_CYCLES) {
+			snprintf(line, sizeof(line), " %14lu %6.2f %8.1f", p->cycles[t],
+			         cycles ? 100.0 * p->cycles[t] / cycles : 0.0,
+			         (r64) p->cycles[t] / p->count[t]);
+			out_str(ob, line);
+		}
+		if (p->flags & PROF_PERF) {
+			snprintf(line, sizeof(line), " %8.1f %10.3f %9.3f",
+			         (r64) p->events[PERF_INSTRUCTIONS][t] / p->count[t],
+			         (r64) p->events[PERF_BRANCH_MISSES][t] / p->count[t],
+			         (r64) p->events[PERF_CACHE_MISSES][t] / p->count[t]);
+			out_str(ob, line);
+		}
+	}
+	out_str(ob, "\n");
+}
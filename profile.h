@@ -0,0 +1,94 @@
+#ifndef profile_h
+#define profile_h
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+#include "tyson.h"
+#include "perfctr.h"
+
+// Opcodes are a byte, so are the counters.
+#define PROF_OPS     (256)
+
+// Profile flags.
+#define PROF_CYCLES  (1 << 0)
+#define PROF_PERF    (1 << 1) // hardware counters too, needs PROF_CYCLES.
+
+/*
+	Profile:
+		Per-opcode execution counts for a context, and with PROF_CYCLES the
+		clock cycles spent in each. While a context has one every dispatch
+		goes through the profiling table, whose one entry ticks the
+		counters then jumps on to the real handler, so contexts without one
+		run exactly as before. Cycles are what passed between an opcode's
+		dispatch and the next one, read from the timestamp counter on
+		x86-64 and in nanoseconds elsewhere, and are only approximately an
+		instruction's own cost, the tick itself included.
+
+		With PROF_PERF the hardware counters in perfctr.h are read on each
+		dispatch as well and their deltas charged the same way, telling a
+		dispatch-bound opcode, many native instructions and branch misses
+		per op, from a memory-bound one, cache misses. The counters are
+		opened by prof_start on whichever thread runs the context.
+
+		PLSTART workers profile into their own and are merged back in when
+		the loop ends. The parent's clock is stopped while they run, so
+		PLSTART is only charged for setting the loop up.
+*/
+struct Profile {
+	u64 flags;
+	u64 count[PROF_OPS];
+	u64 cycles[PROF_OPS];
+	u64 mark;
+	u8  op;
+	u8  timing;
+	u64 events[PERF_EVENTS][PROF_OPS];
+	u64 event_mark[PERF_EVENTS];
+	PerfCounters perf;
+};
+
+Profile* new_profile(u64);
+void     free_profile(Profile*);
+void     prof_start(Profile*);
+void     prof_stop(Profile*);
+void     prof_merge(Profile*, const Profile*);
+void     prof_dump(Profile*, OutBuf*);
+void     prof_events(Profile*);
+
+
+static inline u64
+prof_clock()
+{
+	#if defined(__x86_64__)
+	return __rdtsc();
+	#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64) ts.tv_sec * 1000000000 + ts.tv_nsec;
+	#endif
+}
+
+
+// Called on every dispatch with the opcode about to run.
+static inline void
+prof_tick(Profile* p, u8 op)
+{
+	u64 now;
+
+	++p->count[op];
+	if (p->flags & PROF_CYCLES) {
+		now = prof_clock();
+		if (p->flags & PROF_PERF)
+			prof_events(p);
+		if (p->timing)
+			p->cycles[p->op] += now - p->mark;
+		p->mark   = now;
+		p->op     = op;
+		p->timing = TRUE;
+	}
+}
+
+#endif
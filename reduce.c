@@ -0,0 +1,447 @@
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "tyson.h"
+#include "cpu.h"
+#include "reduce.h"
+
+// Kernel tables are indexed [op][type - U].
+#define REDUCE_TYPES  (3)
+
+typedef u64 (*Reducer)(const u8*, const u8*, u64);
+
+static u64
+as_bits(r64 x)
+{
+	u64 bits;
+	memcpy(&bits, &x, wordsize);
+	return bits;
+}
+
+
+/*
+	Scalar:
+		Element by element, everywhere and for every table too short to
+		fill a vector.
+*/
+
+static u64
+sum_u_scalar(const u8* a, const u8* b, u64 n)
+{
+	const u64* x = (const u64*) a;
+	u64 acc = 0, i;
+
+	for (i=0; i < n; ++i)
+		acc += x[i];
+	return acc;
+}
+
+
+static u64
+sum_r_scalar(const u8* a, const u8* b, u64 n)
+{
+	const r64* x = (const r64*) a;
+	r64 acc = 0;
+	u64 i;
+
+	for (i=0; i < n; ++i)
+		acc += x[i];
+	return as_bits(acc);
+}
+
+
+static u64
+min_u_scalar(const u8* a, const u8* b, u64 n)
+{
+	const u64* x = (const u64*) a;
+	u64 acc = UINT64_MAX, i;
+
+	for (i=0; i < n; ++i)
+		if (x[i] < acc)
+			acc = x[i];
+	return acc;
+}
+
+
+static u64
+min_i_scalar(const u8* a, const u8* b, u64 n)
+{
+	const s64* x = (const s64*) a;
+	s64 acc = INT64_MAX;
+	u64 i;
+
+	for (i=0; i < n; ++i)
+		if (x[i] < acc)
+			acc = x[i];
+	return acc;
+}
+
+
+static u64
+min_r_scalar(const u8* a, const u8* b, u64 n)
+{
+	const r64* x = (const r64*) a;
+	r64 acc = INFINITY;
+	u64 i;
+
+	for (i=0; i < n; ++i)
+		if (x[i] < acc)
+			acc = x[i];
+	return as_bits(acc);
+}
+
+
+static u64
+max_u_scalar(const u8* a, const u8* b, u64 n)
+{
+	const u64* x = (const u64*) a;
+	u64 acc = 0, i;
+
+	for (i=0; i < n; ++i)
+		if (x[i] > acc)
+			acc = x[i];
+	return acc;
+}
+
+
+static u64
+max_i_scalar(const u8* a, const u8* b, u64 n)
+{
+	const s64* x = (const s64*) a;
+	s64 acc = INT64_MIN;
+	u64 i;
+
+	for (i=0; i < n; ++i)
+		if (x[i] > acc)
+			acc = x[i];
+	return acc;
+}
+
+
+static u64
+max_r_scalar(const u8* a, const u8* b, u64 n)
+{
+	const r64* x = (const r64*) a;
+	r64 acc = -INFINITY;
+	u64 i;
+
+	for (i=0; i < n; ++i)
+		if (x[i] > acc)
+			acc = x[i];
+	return as_bits(acc);
+}
+
+
+static u64
+dot_u_scalar(const u8* a, const u8* b, u64 n)
+{
+	const u64* x = (const u64*) a;
+	const u64* y = (const u64*) b;
+	u64 acc = 0, i;
+
+	for (i=0; i < n; ++i)
+		acc += x[i] * y[i];
+	return acc;
+}
+
+
+static u64
+dot_r_scalar(const u8* a, const u8* b, u64 n)
+{
+	const r64* x = (const r64*) a;
+	const r64* y = (const r64*) b;
+	r64 acc = 0;
+	u64 i;
+
+	for (i=0; i < n; ++i)
+		acc += x[i] * y[i];
+	return as_bits(acc);
+}
+
+
+// Wrapping sums and products are the same bits signed or not.
+static const Reducer scalar_kernels[REDUCE_OPS][REDUCE_TYPES] = {
+	{ sum_u_scalar, sum_u_scalar, sum_r_scalar },
+	{ min_u_scalar, min_i_scalar, min_r_scalar },
+	{ max_u_scalar, max_i_scalar, max_r_scalar },
+	{ dot_u_scalar, dot_u_scalar, dot_r_scalar },
+};
+
+static const Reducer (*selected)[REDUCE_TYPES] = scalar_kernels;
+
+
+#if defined(__x86_64__)
+
+/*
+	AVX2:
+		Eight words a step across two accumulators, so one add's latency
+		overlaps the next load, folded across lanes at the end and the
+		last n % 8 words finished by the scalar loop. AVX2 has neither
+		unsigned 64-bit compares nor 64-bit multiplies: unsigned min and
+		max flip the sign bit and compare signed, and products are built
+		from 32-bit halves.
+*/
+
+#define AVX2 __attribute__((target("avx2")))
+
+#define load(p, i) _mm256_loadu_si256((const __m256i*) ((p) + (i)))
+
+
+AVX2 static u64
+fold_u(__m256i v)
+{
+	u64 lanes[4];
+
+	_mm256_storeu_si256((__m256i*) lanes, v);
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+
+AVX2 static r64
+fold_r(__m256d v)
+{
+	r64 lanes[4];
+
+	_mm256_storeu_pd(lanes, v);
+	return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+
+AVX2 static u64
+sum_u_avx2(const u8* a, const u8* b, u64 n)
+{
+	const u64* x = (const u64*) a;
+	__m256i acc0 = _mm256_setzero_si256();
+	__m256i acc1 = _mm256_setzero_si256();
+	u64 i;
+
+	for (i=0; i + 8 <= n; i += 8) {
+		acc0 = _mm256_add_epi64(acc0, load(x, i));
+		acc1 = _mm256_add_epi64(acc1, load(x, i + 4));
+	}
+	return fold_u(_mm256_add_epi64(acc0, acc1)) + sum_u_scalar((const u8*) (x + i), NULL, n - i);
+}
+
+
+AVX2 static u64
+sum_r_avx2(const u8* a, const u8* b, u64 n)
+{
+	const r64* x = (const r64*) a;
+	__m256d acc0 = _mm256_setzero_pd();
+	__m256d acc1 = _mm256_setzero_pd();
+	r64 acc;
+	u64 i;
+
+	for (i=0; i + 8 <= n; i += 8) {
+		acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(x + i));
+		acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(x + i + 4));
+	}
+	acc = fold_r(_mm256_add_pd(acc0, acc1));
+	for (; i < n; ++i)
+		acc += x[i];
+	return as_bits(acc);
+}
+
+
+/*
+	Integer min and max keep their accumulators biased, xored with
+	bias, so the unsigned kind costs one xor a load.
+*/
+AVX2 static u64
+minmax_avx2(const u64* x, u64 n, u8 max, u64 bias, u64 init)
+{
+	__m256i vbias = _mm256_set1_epi64x(bias);
+	__m256i acc0 = _mm256_set1_epi64x(init ^ bias);
+	__m256i acc1 = acc0;
+	__m256i v0, v1;
+	u64 lanes[4], acc, i, j;
+
+	for (i=0; i + 8 <= n; i += 8) {
+		v0 = _mm256_xor_si256(load(x, i), vbias);
+		v1 = _mm256_xor_si256(load(x, i + 4), vbias);
+		if (max) {
+			acc0 = _mm256_blendv_epi8(acc0, v0, _mm256_cmpgt_epi64(v0, acc0));
+			acc1 = _mm256_blendv_epi8(acc1, v1, _mm256_cmpgt_epi64(v1, acc1));
+		} else {
+			acc0 = _mm256_blendv_epi8(acc0, v0, _mm256_cmpgt_epi64(acc0, v0));
+			acc1 = _mm256_blendv_epi8(acc1, v1, _mm256_cmpgt_epi64(acc1, v1));
+		}
+	}
+	if (max)
+		acc0 = _mm256_blendv_epi8(acc0, acc1, _mm256_cmpgt_epi64(acc1, acc0));
+	else
+		acc0 = _mm256_blendv_epi8(acc0, acc1, _mm256_cmpgt_epi64(acc0, acc1));
+
+	_mm256_storeu_si256((__m256i*) lanes, acc0);
+	acc = init ^ bias;
+	for (j=0; j < 4; ++j)
+		if (max ? ((s64) lanes[j] > (s64) acc) : ((s64) lanes[j] < (s64) acc))
+			acc = lanes[j];
+	for (; i < n; ++i)
+		if (max ? ((s64) (x[i] ^ bias) > (s64) acc) : ((s64) (x[i] ^ bias) < (s64) acc))
+			acc = x[i] ^ bias;
+	return acc ^ bias;
+}
+
+
+AVX2 static u64
+min_u_avx2(const u8* a, const u8* b, u64 n)
+{
+	return minmax_avx2((const u64*) a, n, FALSE, (u64) 1 << 63, UINT64_MAX);
+}
+
+
+AVX2 static u64
+min_i_avx2(const u8* a, const u8* b, u64 n)
+{
+	return minmax_avx2((const u64*) a, n, FALSE, 0, INT64_MAX);
+}
+
+
+AVX2 static u64
+max_u_avx2(const u8* a, const u8* b, u64 n)
+{
+	return minmax_avx2((const u64*) a, n, TRUE, (u64) 1 << 63, 0);
+}
+
+
+AVX2 static u64
+max_i_avx2(const u8* a, const u8* b, u64 n)
+{
+	return minmax_avx2((const u64*) a, n, TRUE, 0, (u64) INT64_MIN);
+}
+
+
+// min_pd and max_pd return their second operand when either is NaN.
+AVX2 static u64
+minmax_r_avx2(const r64* x, u64 n, u8 max)
+{
+	r64 init = max ? -INFINITY : INFINITY;
+	__m256d acc0 = _mm256_set1_pd(init);
+	__m256d acc1 = acc0;
+	r64 lanes[4], acc = init;
+	u64 i, j;
+
+	for (i=0; i + 8 <= n; i += 8) {
+		if (max) {
+			acc0 = _mm256_max_pd(_mm256_loadu_pd(x + i), acc0);
+			acc1 = _mm256_max_pd(_mm256_loadu_pd(x + i + 4), acc1);
+		} else {
+			acc0 = _mm256_min_pd(_mm256_loadu_pd(x + i), acc0);
+			acc1 = _mm256_min_pd(_mm256_loadu_pd(x + i + 4), acc1);
+		}
+	}
+	acc0 = max ? _mm256_max_pd(acc0, acc1) : _mm256_min_pd(acc0, acc1);
+
+	_mm256_storeu_pd(lanes, acc0);
+	for (j=0; j < 4; ++j)
+		if (max ? (lanes[j] > acc) : (lanes[j] < acc))
+			acc = lanes[j];
+	for (; i < n; ++i)
+		if (max ? (x[i] > acc) : (x[i] < acc))
+			acc = x[i];
+	return as_bits(acc);
+}
+
+
+AVX2 static u64
+min_r_avx2(const u8* a, const u8* b, u64 n)
+{
+	return minmax_r_avx2((const r64*) a, n, FALSE);
+}
+
+
+AVX2 static u64
+max_r_avx2(const u8* a, const u8* b, u64 n)
+{
+	return minmax_r_avx2((const r64*) a, n, TRUE);
+}
+
+
+// Low 64 bits of each lane's product: lo*lo + ((hi*lo + lo*hi) << 32).
+AVX2 static __m256i
+mul_u64(__m256i a, __m256i b)
+{
+	__m256i lo    = _mm256_mul_epu32(a, b);
+	__m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+	                                 _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+
+	return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+}
+
+
+AVX2 static u64
+dot_u_avx2(const u8* a, const u8* b, u64 n)
+{
+	const u64* x = (const u64*) a;
+	const u64* y = (const u64*) b;
+	__m256i acc0 = _mm256_setzero_si256();
+	__m256i acc1 = _mm256_setzero_si256();
+	u64 i;
+
+	for (i=0; i + 8 <= n; i += 8) {
+		acc0 = _mm256_add_epi64(acc0, mul_u64(load(x, i), load(y, i)));
+		acc1 = _mm256_add_epi64(acc1, mul_u64(load(x, i + 4), load(y, i + 4)));
+	}
+	return fold_u(_mm256_add_epi64(acc0, acc1)) +
+	       dot_u_scalar((const u8*) (x + i), (const u8*) (y + i), n - i);
+}
+
+
+AVX2 static u64
+dot_r_avx2(const u8* a, const u8* b, u64 n)
+{
+	const r64* x = (const r64*) a;
+	const r64* y = (const r64*) b;
+	__m256d acc0 = _mm256_setzero_pd();
+	__m256d acc1 = _mm256_setzero_pd();
+	r64 acc;
+	u64 i;
+
+	for (i=0; i + 8 <= n; i += 8) {
+		acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+		acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4)));
+	}
+	acc = fold_r(_mm256_add_pd(acc0, acc1));
+	for (; i < n; ++i)
+		acc += x[i] * y[i];
+	return as_bits(acc);
+}
+
+
+static const Reducer avx2_kernels[REDUCE_OPS][REDUCE_TYPES] = {
+	{ sum_u_avx2, sum_u_avx2, sum_r_avx2 },
+	{ min_u_avx2, min_i_avx2, min_r_avx2 },
+	{ max_u_avx2, max_i_avx2, max_r_avx2 },
+	{ dot_u_avx2, dot_u_avx2, dot_r_avx2 },
+};
+
+#endif
+
+
+// AVX2 rows replace the scalar table before main when the cpu has them.
+__attribute__((constructor))
+static void
+select_kernels()
+{
+	#if defined(__x86_64__)
+	if (cpu_features() & CPU_AVX2)
+		selected = avx2_kernels;
+	#endif
+}
+
+
+int
+reduce(u8 op, u64 type, const u8* a, const u8* b, u64 n, u64* result)
+{
+	if (op >= REDUCE_OPS || type < U || type > R)
+		return FALSE;
+
+	*result = selected[op][type - U](a, b, n);
+	return TRUE;
+}
@@ -0,0 +1,27 @@
+#ifndef reduce_h
+#define reduce_h
+
+#include "tyson.h"
+
+// Reductions, the RED_* instructions in the same order.
+#define REDUCE_SUM  (0)
+#define REDUCE_MIN  (1)
+#define REDUCE_MAX  (2)
+#define REDUCE_DOT  (3)
+#define REDUCE_OPS  (4)
+
+/*
+	Reduce:
+		Folds n words of a table into one, typed U, I or R as the type
+		codes in tyson.h, writing its bits to result. Dot takes a second
+		table of n words, the others ignore it. Integer sums and products
+		wrap like ADD and MUL, an empty table gives 0 for sum and dot and
+		the type's identity for min and max, and NaNs never win a min or
+		max. Vector kernels add reals in lanes, so their sums can round
+		differently from an element by element loop.
+
+		Returns FALSE for a type it doesn't know.
+*/
+int reduce(u8 op, u64 type, const u8* a, const u8* b, u64 n, u64* result);
+
+#endif
@@ -0,0 +1,236 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "tyson.h"
+#include "sample.h"
+#include "dbinfo.h"
+
+// Older glibc names the thread id member of sigevent only this way.
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+
+// Just a mark, the sampling table does the work between instructions.
+static void
+on_sigprof(int sig, siginfo_t* si, void* uc)
+{
+	Sampler* s = (Sampler*) si->si_value.sival_ptr;
+
+	if (s)
+		s->pending = 1;
+}
+
+
+Sampler*
+new_sampler(u64 hz)
+{
+	Sampler* s = (Sampler*) calloc(1, sizeof(Sampler));
+	struct sigaction sa;
+
+	if (!s)
+		return 0;
+
+	s->period = 1000000000 / (hz ? hz : SAMPLE_DEFAULT_HZ);
+
+	// Restarting keeps file reads and AWAIT from failing when a tick lands.
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_sigaction = on_sigprof;
+	sa.sa_flags = SA_SIGINFO | SA_RESTART;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGPROF, &sa, 0);
+	return s;
+}
+
+
+void
+free_sampler(Sampler* s)
+{
+	if (!s)
+		return;
+	if (s->tid)
+		timer_delete(s->timer);
+	free(s->buf);
+	free(s);
+}
+
+
+// Starts the clock for the calling thread, making its timer if it hasn't one.
+void
+sampler_arm(Sampler* s)
+{
+	struct sigevent sev;
+	struct itimerspec its;
+	pid_t tid = (pid_t) syscall(SYS_gettid);
+
+	if (s->tid != tid) {
+		if (s->tid)
+			timer_delete(s->timer);
+		s->tid = 0;
+
+		memset(&sev, 0, sizeof(sev));
+		sev.sigev_notify = SIGEV_THREAD_ID;
+		sev.sigev_signo  = SIGPROF;
+		sev.sigev_value.sival_ptr = s;
+		sev.sigev_notify_thread_id = tid;
+		if (timer_create(CLOCK_THREAD_CPUTIME_ID, &sev, &s->timer) < 0)
+			return;
+		s->tid = tid;
+	}
+
+	its.it_value.tv_sec  = s->period / 1000000000;
+	its.it_value.tv_nsec = s->period % 1000000000;
+	its.it_interval = its.it_value;
+	timer_settime(s->timer, 0, &its, 0);
+}
+
+
+void
+sampler_disarm(Sampler* s)
+{
+	struct itimerspec its;
+
+	if (!s->tid)
+		return;
+	memset(&its, 0, sizeof(its));
+	timer_settime(s->timer, 0, &its, 0);
+}
+
+
+/*
+	Record:
+		Takes a sample of ip and the return stack, rstk[1] up to rp, the
+		deepest entry being the innermost call. Return addresses outside
+		the image, like ty_call's, end the walk. Drops the sample if the
+		buffer can't grow.
+*/
+void
+sampler_record(Sampler* s, Process* pro, u8* ip, u8** rstk, u8** rp)
+{
+	u64 need = (rp - rstk) + 2;
+	u64 cap, n = 0;
+	u64* buf;
+	u8** p;
+
+	s->pending = 0;
+	if (s->len + need > s->cap) {
+		cap = s->cap ? s->cap * 2 : 4096;
+		while (cap < s->len + need)
+			cap *= 2;
+		buf = (u64*) realloc(s->buf, cap * wordsize);
+		if (!buf)
+			return;
+		s->buf = buf;
+		s->cap = cap;
+	}
+
+	s->buf[s->len + 1 + n++] = ip - pro->img;
+	for (p=rp; p > rstk; --p) {
+		if (*p < pro->img || *p >= pro->img + pro->size)
+			break;
+		s->buf[s->len + 1 + n++] = *p - pro->img;
+	}
+	s->buf[s->len] = n;
+	s->len += n + 1;
+	++s->samples;
+}
+
+
+int
+sampler_write(Sampler* s, const char* path)
+{
+	FILE* f = fopen(path, "w");
+	u64 i, j, n;
+
+	if (!f)
+		return -1;
+
+	for (i=0; i < s->len; i += n + 1) {
+		n = s->buf[i];
+		for (j=1; j <= n; ++j)
+			fprintf(f, (j > 1) ? " %lu" : "%lu", s->buf[i + j]);
+		fputc('\n', f);
+	}
+	return fclose(f);
+}
+
+
+// The name a frame goes by, its label or else its offset.
+static u64
+frame_name(DebugInfo* info, u64 addr, char* buf, u64 size)
+{
+	const char* label = info ? dbinfo_label(info, addr, 0) : 0;
+
+	if (label)
+		return snprintf(buf, size, "%s", label);
+	return snprintf(buf, size, "@%lu", addr);
+}
+
+
+static int
+cmp_stack(const void* a, const void* b)
+{
+	return strcmp(*((char* const*) a), *((char* const*) b));
+}
+
+
+/*
+	Write Folded:
+		Writes the samples as collapsed stacks, the format flamegraph.pl
+		and its like read: one line per distinct stack, its frames from
+		the outermost call in separated by semicolons, then how many
+		samples saw it. Frames are named by the label at or before them
+		from the process' debug info, a return address by the call just
+		before it, and by their offset when the image has no debug info.
+*/
+int
+sampler_write_folded(Sampler* s, Process* pro, const char* path)
+{
+	DebugInfo* info = process_debug_info(pro);
+	char**     stacks = (char**) malloc((s->samples ? s->samples : 1) * sizeof(char*));
+	char       name[256];
+	char*      stack;
+	u64        i, j, n, k = 0, len, cap, count;
+	FILE*      f;
+
+	if (!stacks)
+		return -1;
+
+	for (i=0; i < s->len; i += n + 1) {
+		n = s->buf[i];
+		cap = 64;
+		len = 0;
+		stack = (char*) malloc(cap);
+		if (!stack)
+			break;
+		stack[0] = 0;
+		for (j=n; j >= 1; --j) {
+			frame_name(info, (j > 1) ? s->buf[i + j] - 1 : s->buf[i + j], name, sizeof(name));
+			if (len + strlen(name) + 2 > cap) {
+				while (len + strlen(name) + 2 > cap)
+					cap *= 2;
+				stack = (char*) realloc(stack, cap);
+			}
+			len += sprintf(stack + len, (j < n) ? ";%s" : "%s", name);
+		}
+		stacks[k++] = stack;
+	}
+
+	qsort(stacks, k, sizeof(char*), cmp_stack);
+
+	f = fopen(path, "w");
+	for (i=0; i < k; i += count) {
+		for (count=1; i + count < k && !strcmp(stacks[i], stacks[i + count]); ++count)
+			;
+		if (f)
+			fprintf(f, "%s %lu\n", stacks[i], count);
+	}
+
+	for (i=0; i < k; ++i)
+		free(stacks[i]);
+	free(stacks);
+	return f ? fclose(f) : -1;
+}
@@ -0,0 +1,51 @@
+#ifndef sample_h
+#define sample_h
+
+#include <signal.h>
+#include <time.h>
+#include <sys/types.h>
+
+#include "tyson.h"
+
+#define SAMPLE_DEFAULT_HZ  (997)
+
+/*
+	Sampler:
+		Records where a context is every so often, ip and the return
+		addresses on its return stack, for typrof.py to put names to from
+		an image assembled with -g.
+
+		A timer on the running thread's cpu clock raises SIGPROF, whose
+		handler only marks the sampler pending. While a context has a
+		sampler it runs on the sampling table, every entry of which checks
+		the mark before going on to the optable, so the sample is taken
+		between instructions with the registers at hand and put down to
+		the instruction that was running when the tick came, and contexts
+		without one run exactly as before. The timer runs only while the
+		context is inside interpret. PLSTART workers aren't sampled.
+
+		Samples are written one per line, img-relative offsets in
+		decimal, ip then each return address from the innermost call out,
+		or with sampler_write_folded as collapsed stacks named through
+		the process' debug info, ready for flame-graph tools.
+*/
+struct Sampler {
+	volatile sig_atomic_t pending;
+	u64     period;  // ns of cpu time between samples.
+	timer_t timer;
+	pid_t   tid;     // thread the timer was made for, 0 if none.
+	u64*    buf;     // per sample, frame count then that many offsets.
+	u64     len;
+	u64     cap;
+	u64     samples;
+};
+
+Sampler* new_sampler(u64);
+void     free_sampler(Sampler*);
+void     sampler_arm(Sampler*);
+void     sampler_disarm(Sampler*);
+void     sampler_record(Sampler*, Process*, u8*, u8**, u8**);
+int      sampler_write(Sampler*, const char*);
+int      sampler_write_folded(Sampler*, Process*, const char*);
+
+#endif
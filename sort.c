@@ -0,0 +1,241 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "tyson.h"
+#include "sort.h"
+
+#define digit_of(key, d) \
+	(((key) >> ((d) * SORT_DIGIT_BITS)) & (SORT_BUCKETS - 1))
+
+// One thread's slice of the table and its share of each pass.
+typedef struct {
+	u64* src;
+	u64* dst;
+	u64  lo;
+	u64  hi;
+	u64  stride;
+	u64  digit;
+	u8   type;
+	u64  counts[SORT_DIGITS][SORT_BUCKETS];
+	u64  offs[SORT_BUCKETS];
+} SortJob;
+
+
+static u64
+to_radix(u64 key, u8 type)
+{
+	switch (type) {
+		case I:
+			return key ^ ((u64) 1 << 63);
+		case R:
+			return (key >> 63) ? ~key : key ^ ((u64) 1 << 63);
+		default:
+			return key;
+	}
+}
+
+
+static u64
+from_radix(u64 key, u8 type)
+{
+	switch (type) {
+		case I:
+			return key ^ ((u64) 1 << 63);
+		case R:
+			return (key >> 63) ? key ^ ((u64) 1 << 63) : ~key;
+		default:
+			return key;
+	}
+}
+
+
+// Maps its slice's keys and counts every digit of them in one read.
+static void*
+count_slice(void* arg)
+{
+	SortJob* job = (SortJob*) arg;
+	u64* key;
+	u64 i, d;
+
+	memset(job->counts, 0, sizeof(job->counts));
+	for (i=job->lo; i < job->hi; ++i) {
+		key  = job->src + i * job->stride;
+		*key = to_radix(*key, job->type);
+		for (d=0; d < SORT_DIGITS; ++d)
+			++job->counts[d][digit_of(*key, d)];
+	}
+	return NULL;
+}
+
+
+// Recounts one digit once earlier passes have moved keys between slices.
+static void*
+recount_slice(void* arg)
+{
+	SortJob* job = (SortJob*) arg;
+	u64 i;
+
+	memset(job->counts[job->digit], 0, sizeof(job->counts[0]));
+	for (i=job->lo; i < job->hi; ++i)
+		++job->counts[job->digit][digit_of(job->src[i * job->stride], job->digit)];
+	return NULL;
+}
+
+
+static void*
+scatter_slice(void* arg)
+{
+	SortJob* job = (SortJob*) arg;
+	u64* src;
+	u64* dst;
+	u64 i;
+
+	for (i=job->lo; i < job->hi; ++i) {
+		src = job->src + i * job->stride;
+		dst = job->dst + (job->offs[digit_of(*src, job->digit)]++) * job->stride;
+		dst[0] = src[0];
+		if (job->stride > 1)
+			dst[1] = src[1];
+	}
+	return NULL;
+}
+
+
+// Runs func over every job, the first on this thread, inline if a spawn fails.
+static void
+run_jobs(void* (*func)(void*), SortJob* jobs, u64 workers)
+{
+	pthread_t threads[SORT_MAX_WORKERS];
+	u8 spawned[SORT_MAX_WORKERS];
+	u64 i;
+
+	for (i=1; i < workers; ++i)
+		spawned[i] = (pthread_create(&threads[i], 0, func, &jobs[i]) == 0);
+
+	func(&jobs[0]);
+
+	for (i=1; i < workers; ++i) {
+		if (spawned[i])
+			pthread_join(threads[i], 0);
+		else
+			func(&jobs[i]);
+	}
+}
+
+
+static void
+insertion_sort(u64* base, u64 n, u64 stride, u8 type)
+{
+	u64 key, payload = 0, i, j;
+
+	for (i=0; i < n; ++i)
+		base[i * stride] = to_radix(base[i * stride], type);
+
+	for (i=1; i < n; ++i) {
+		key = base[i * stride];
+		if (stride > 1)
+			payload = base[i * stride + 1];
+		for (j=i; j > 0 && base[(j - 1) * stride] > key; --j) {
+			base[j * stride] = base[(j - 1) * stride];
+			if (stride > 1)
+				base[j * stride + 1] = base[(j - 1) * stride + 1];
+		}
+		base[j * stride] = key;
+		if (stride > 1)
+			base[j * stride + 1] = payload;
+	}
+
+	for (i=0; i < n; ++i)
+		base[i * stride] = from_radix(base[i * stride], type);
+}
+
+
+int
+sort_table(u8* base, u64 n, u64 type, u8 pairs)
+{
+	SortJob* jobs;
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	u64 stride = pairs ? 2 : 1;
+	u64 workers = 1, chunk, total, d, b, i;
+	u8  moved = FALSE;
+	u64* table = (u64*) base;
+	u64* scratch;
+	u64* tmp;
+
+	if (type < U || type > R)
+		return FALSE;
+
+	if (n <= SORT_SMALL) {
+		insertion_sort(table, n, stride, type);
+		return TRUE;
+	}
+
+	if (n >= SORT_PARALLEL_MIN && cpus > 1) {
+		workers = (u64) cpus;
+		if (workers > SORT_MAX_WORKERS)
+			workers = SORT_MAX_WORKERS;
+	}
+
+	scratch = malloc(n * stride * wordsize);
+	jobs = malloc(workers * sizeof(SortJob));
+	if (!scratch || !jobs) {
+		free(scratch);
+		free(jobs);
+		return FALSE;
+	}
+
+	chunk = (n + workers - 1) / workers;
+	for (i=0; i < workers; ++i) {
+		jobs[i].src    = table;
+		jobs[i].dst    = scratch;
+		jobs[i].lo     = (i * chunk < n) ? i * chunk : n;
+		jobs[i].hi     = ((i + 1) * chunk < n) ? (i + 1) * chunk : n;
+		jobs[i].stride = stride;
+		jobs[i].type   = type;
+	}
+	run_jobs(count_slice, jobs, workers);
+
+	for (d=0; d < SORT_DIGITS; ++d) {
+		// Every key sharing this digit leaves the order as it is.
+		for (b=0; b < SORT_BUCKETS; ++b) {
+			for (total=0, i=0; i < workers; ++i)
+				total += jobs[i].counts[d][b];
+			if (total)
+				break;
+		}
+		if (total == n)
+			continue;
+
+		for (i=0; i < workers; ++i)
+			jobs[i].digit = d;
+		if (moved && workers > 1)
+			run_jobs(recount_slice, jobs, workers);
+
+		// Bucket by bucket, each slice's keys go after the slices before it.
+		for (total=0, b=0; b < SORT_BUCKETS; ++b) {
+			for (i=0; i < workers; ++i) {
+				jobs[i].offs[b] = total;
+				total += jobs[i].counts[d][b];
+			}
+		}
+		run_jobs(scatter_slice, jobs, workers);
+		moved = TRUE;
+
+		for (i=0; i < workers; ++i) {
+			tmp = jobs[i].src;
+			jobs[i].src = jobs[i].dst;
+			jobs[i].dst = tmp;
+		}
+	}
+
+	if (jobs[0].src != table)
+		memcpy(table, jobs[0].src, n * stride * wordsize);
+	for (i=0; i < n; ++i)
+		table[i * stride] = from_radix(table[i * stride], type);
+
+	free(scratch);
+	free(jobs);
+	return TRUE;
+}
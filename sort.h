@@ -0,0 +1,40 @@
+#ifndef sort_h
+#define sort_h
+
+#include "tyson.h"
+
+// Radix digits, enough of them to cover a word.
+#define SORT_DIGIT_BITS    (11)
+#define SORT_BUCKETS       (1 << SORT_DIGIT_BITS)
+#define SORT_DIGITS        ((64 + SORT_DIGIT_BITS - 1) / SORT_DIGIT_BITS)
+
+// Tables this short are insertion sorted.
+#define SORT_SMALL         (64)
+
+// Tables this long are split between threads.
+#define SORT_PARALLEL_MIN  ((u64) 1 << 20)
+#define SORT_MAX_WORKERS   (16)
+
+/*
+	Sort:
+		Sorts n elements at base ascending by their first word, typed U,
+		I or R as the type codes in tyson.h. Elements are one word, or
+		with pairs set a key word followed by a payload word that moves
+		with it. Stable, so equal keys keep their order.
+
+		An LSD radix sort, 11 bits a pass, with keys first mapped to
+		unsigned words that order the same way: signed keys flip their
+		sign bit, reals flip their sign bit when positive and every bit
+		when negative. That puts -0 before 0 and NaNs at the ends by
+		their sign. Passes where every key has the same digit are
+		skipped, so small keys sort in a pass or two. Tables past
+		SORT_PARALLEL_MIN are split between threads for each pass, each
+		counting and moving its own slice to the places worked out from
+		every slice's counts.
+
+		Returns FALSE for a type it doesn't know or when the scratch
+		buffer can't be had, leaving the table as it was.
+*/
+int sort_table(u8* base, u64 n, u64 type, u8 pairs);
+
+#endif
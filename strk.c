@@ -0,0 +1,367 @@
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "tyson.h"
+#include "cpu.h"
+#include "strk.h"
+
+// Bitmap of the bytes in a NUL-terminated set, NUL always included.
+#define set_bit(map, c)   ((map)[(c) >> 3] |= (u8) (1 << ((c) & 7)))
+#define test_bit(map, c)  ((map)[(c) >> 3] & (1 << ((c) & 7)))
+
+static const StrKernels* selected = &strk_scalar;
+
+
+static void
+byte_set(u8* map, const u8* set)
+{
+	memset(map, 0, 32);
+	set_bit(map, 0);
+	for (; *set; ++set)
+		set_bit(map, *set);
+}
+
+
+/*
+	Scalar:
+		Portable kernels, and the baseline the vector ones are measured
+		against.
+*/
+
+static s64
+chr_scalar(const u8* s, u8 c)
+{
+	const u8* p;
+
+	for (p=s; *p != c; ++p)
+		if (!*p)
+			return -1;
+	return p - s;
+}
+
+
+static u64
+cspn_scalar(const u8* s, const u8* reject)
+{
+	u8 map[32];
+	const u8* p;
+
+	byte_set(map, reject);
+	for (p=s; !test_bit(map, *p); ++p);
+	return p - s;
+}
+
+
+static s64
+str_scalar(const u8* s, const u8* needle)
+{
+	const u8* p;
+	u64 i;
+
+	if (!*needle)
+		return 0;
+
+	for (p=s; *p; ++p) {
+		for (i=0; needle[i] && p[i] == needle[i]; ++i);
+		if (!needle[i])
+			return p - s;
+	}
+	return -1;
+}
+
+
+const StrKernels strk_scalar = {
+	"scalar", chr_scalar, cspn_scalar, str_scalar
+};
+
+
+#if defined(__x86_64__)
+
+/*
+	SSE2:
+		16 bytes a step. The first load is aligned down to the block
+		holding s and the bytes before s shifted out of its mask, after
+		which every load is aligned. SSE2 has no byte shuffle, so spans
+		test each reject byte in turn, good for the short sets programs
+		mostly use, and fall back to the bitmap past 16 of them.
+*/
+
+static s64
+chr_sse2(const u8* s, u8 c)
+{
+	u64 off = (u64) s & 15;
+	const u8* p = s - off;
+	__m128i vc = _mm_set1_epi8((char) c);
+	__m128i vz = _mm_setzero_si128();
+	__m128i v;
+	u32 mask;
+
+	v = _mm_load_si128((const __m128i*) p);
+	mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, vc), _mm_cmpeq_epi8(v, vz)));
+	mask >>= off;
+	if (mask) {
+		p = s + __builtin_ctz(mask);
+		return (*p == c) ? p - s : -1;
+	}
+
+	for (;;) {
+		p += 16;
+		v = _mm_load_si128((const __m128i*) p);
+		mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, vc), _mm_cmpeq_epi8(v, vz)));
+		if (mask) {
+			p += __builtin_ctz(mask);
+			return (*p == c) ? p - s : -1;
+		}
+	}
+}
+
+
+static u32
+cspn_block_sse2(__m128i v, const __m128i* set, u64 n)
+{
+	__m128i hits = _mm_cmpeq_epi8(v, _mm_setzero_si128());
+	u64 i;
+
+	for (i=0; i < n; ++i)
+		hits = _mm_or_si128(hits, _mm_cmpeq_epi8(v, set[i]));
+	return _mm_movemask_epi8(hits);
+}
+
+
+static u64
+cspn_sse2(const u8* s, const u8* reject)
+{
+	__m128i set[16];
+	u64 n, off = (u64) s & 15;
+	const u8* p = s - off;
+	u32 mask;
+
+	for (n=0; reject[n]; ++n) {
+		if (n == 16)
+			return cspn_scalar(s, reject);
+		set[n] = _mm_set1_epi8((char) reject[n]);
+	}
+
+	mask = cspn_block_sse2(_mm_load_si128((const __m128i*) p), set, n) >> off;
+	if (mask)
+		return __builtin_ctz(mask);
+
+	for (;;) {
+		p += 16;
+		mask = cspn_block_sse2(_mm_load_si128((const __m128i*) p), set, n);
+		if (mask)
+			return (p - s) + __builtin_ctz(mask);
+	}
+}
+
+
+/*
+	Substring search filters candidates on the needle's first and last
+	bytes a block at a time and compares only the positions where both
+	match. That needs loads at any offset, so the haystack's length is
+	found first (chr for NUL, itself vectorized) to keep every load in
+	bounds, and the last few positions are left to the scalar compare.
+*/
+static s64
+str_sse2(const u8* s, const u8* needle)
+{
+	u64 n, k, i;
+	__m128i first, last, a, b;
+	u32 mask;
+
+	if (!needle[0])
+		return 0;
+	if (!needle[1])
+		return chr_sse2(s, needle[0]);
+
+	n = chr_sse2(s, 0);
+	k = strlen((const char*) needle);
+	if (k > n)
+		return -1;
+
+	first = _mm_set1_epi8((char) needle[0]);
+	last  = _mm_set1_epi8((char) needle[k - 1]);
+
+	for (i=0; i + k - 1 + 16 <= n; i += 16) {
+		a = _mm_loadu_si128((const __m128i*) (s + i));
+		b = _mm_loadu_si128((const __m128i*) (s + i + k - 1));
+		mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+		for (; mask; mask &= mask - 1)
+			if (!memcmp(s + i + __builtin_ctz(mask) + 1, needle + 1, k - 2))
+				return i + __builtin_ctz(mask);
+	}
+
+	for (; i + k <= n; ++i)
+		if (s[i] == needle[0] && !memcmp(s + i + 1, needle + 1, k - 1))
+			return i;
+	return -1;
+}
+
+
+const StrKernels strk_sse2 = {
+	"sse2", chr_sse2, cspn_sse2, str_sse2
+};
+
+
+/*
+	AVX2:
+		The SSE2 kernels 32 bytes a step, with spans looking every byte up
+		in the reject bitmap at once, for sets of any size. The bitmap is
+		split into two 16 byte tables indexed by a byte's low nibble, one
+		holding the high nibbles 0-7 as bits and the other 8-15, and the
+		high nibble picks the table and the bit.
+*/
+
+__attribute__((target("avx2")))
+static s64
+chr_avx2(const u8* s, u8 c)
+{
+	u64 off = (u64) s & 31;
+	const u8* p = s - off;
+	__m256i vc = _mm256_set1_epi8((char) c);
+	__m256i vz = _mm256_setzero_si256();
+	__m256i v;
+	u32 mask;
+
+	v = _mm256_load_si256((const __m256i*) p);
+	mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, vc), _mm256_cmpeq_epi8(v, vz)));
+	mask >>= off;
+	if (mask) {
+		p = s + __builtin_ctz(mask);
+		return (*p == c) ? p - s : -1;
+	}
+
+	for (;;) {
+		p += 32;
+		v = _mm256_load_si256((const __m256i*) p);
+		mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, vc), _mm256_cmpeq_epi8(v, vz)));
+		if (mask) {
+			p += __builtin_ctz(mask);
+			return (*p == c) ? p - s : -1;
+		}
+	}
+}
+
+
+__attribute__((target("avx2")))
+static inline u32
+cspn_block_avx2(__m256i v, __m256i lo_tab, __m256i hi_tab, __m256i bits)
+{
+	__m256i nib = _mm256_set1_epi8(0x0f);
+	__m256i lo  = _mm256_and_si256(v, nib);
+	__m256i hi  = _mm256_and_si256(_mm256_srli_epi16(v, 4), nib);
+	__m256i row = _mm256_blendv_epi8(_mm256_shuffle_epi8(lo_tab, lo),
+	                                 _mm256_shuffle_epi8(hi_tab, lo),
+	                                 _mm256_cmpgt_epi8(hi, _mm256_set1_epi8(7)));
+	__m256i bit = _mm256_shuffle_epi8(bits, hi);
+
+	return _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(row, bit), bit));
+}
+
+
+__attribute__((target("avx2")))
+static u64
+cspn_avx2(const u8* s, const u8* reject)
+{
+	u8 lo[16], hi[16];
+	u64 off = (u64) s & 31;
+	const u8* p = s - off;
+	__m256i lo_tab, hi_tab, bits;
+	u32 mask;
+
+	memset(lo, 0, 16);
+	memset(hi, 0, 16);
+	lo[0] = 1;
+	for (; *reject; ++reject) {
+		if (*reject < 128)
+			lo[*reject & 15] |= (u8) (1 << (*reject >> 4));
+		else
+			hi[*reject & 15] |= (u8) (1 << ((*reject >> 4) - 8));
+	}
+
+	lo_tab = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) lo));
+	hi_tab = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) hi));
+	bits   = _mm256_broadcastsi128_si256(_mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128,
+	                                                   1, 2, 4, 8, 16, 32, 64, -128));
+
+	mask = cspn_block_avx2(_mm256_load_si256((const __m256i*) p), lo_tab, hi_tab, bits) >> off;
+	if (mask)
+		return __builtin_ctz(mask);
+
+	for (;;) {
+		p += 32;
+		mask = cspn_block_avx2(_mm256_load_si256((const __m256i*) p), lo_tab, hi_tab, bits);
+		if (mask)
+			return (p - s) + __builtin_ctz(mask);
+	}
+}
+
+
+__attribute__((target("avx2")))
+static s64
+str_avx2(const u8* s, const u8* needle)
+{
+	u64 n, k, i;
+	__m256i first, last, a, b;
+	u32 mask;
+
+	if (!needle[0])
+		return 0;
+	if (!needle[1])
+		return chr_avx2(s, needle[0]);
+
+	n = chr_avx2(s, 0);
+	k = strlen((const char*) needle);
+	if (k > n)
+		return -1;
+
+	first = _mm256_set1_epi8((char) needle[0]);
+	last  = _mm256_set1_epi8((char) needle[k - 1]);
+
+	for (i=0; i + k - 1 + 32 <= n; i += 32) {
+		a = _mm256_loadu_si256((const __m256i*) (s + i));
+		b = _mm256_loadu_si256((const __m256i*) (s + i + k - 1));
+		mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last)));
+		for (; mask; mask &= mask - 1)
+			if (!memcmp(s + i + __builtin_ctz(mask) + 1, needle + 1, k - 2))
+				return i + __builtin_ctz(mask);
+	}
+
+	for (; i + k <= n; ++i)
+		if (s[i] == needle[0] && !memcmp(s + i + 1, needle + 1, k - 1))
+			return i;
+	return -1;
+}
+
+
+const StrKernels strk_avx2 = {
+	"avx2", chr_avx2, cspn_avx2, str_avx2
+};
+
+#endif
+
+
+// Before main, swaps in the AVX2 or SSE2 kernels when the cpu has them.
+__attribute__((constructor))
+static void
+select_kernels()
+{
+	#if defined(__x86_64__)
+	u64 features = cpu_features();
+
+	if (features & CPU_AVX2)
+		selected = &strk_avx2;
+	else if (features & CPU_SSE2)
+		selected = &strk_sse2;
+	#endif
+}
+
+
+const StrKernels*
+str_kernels()
+{
+	return selected;
+}
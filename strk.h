@@ -0,0 +1,36 @@
+#ifndef strk_h
+#define strk_h
+
+#include "tyson.h"
+
+/*
+	String Kernels:
+		The search behind STR_CHR, STR_CSPN and STR_STR over NUL-terminated
+		strings, built once portably and once per x86 instruction set, the
+		best the cpu runs being picked when the program loads.
+
+		chr   index of the first c in s, or -1. c may be 0, finding the end.
+		cspn  length of s's first run of bytes not in reject.
+		str   index of the first needle in s, or -1. An empty needle is
+		      found at 0.
+
+		Vector kernels only ever load whole aligned blocks until they
+		know where the string ends, so like libc's they may read past the
+		NUL but never into a page the string doesn't touch.
+*/
+typedef struct {
+	const char* name;
+	s64 (*chr)(const u8*, u8);
+	u64 (*cspn)(const u8*, const u8*);
+	s64 (*str)(const u8*, const u8*);
+} StrKernels;
+
+extern const StrKernels strk_scalar;
+#if defined(__x86_64__)
+extern const StrKernels strk_sse2;
+extern const StrKernels strk_avx2;
+#endif
+
+const StrKernels* str_kernels();
+
+#endif
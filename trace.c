@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tyson.h"
+#include "trace.h"
+
+
+// Size is the ring's, rounded down to whole blocks and at least two of them.
+Tracer*
+new_tracer(u64 size)
+{
+	Tracer* t = (Tracer*) calloc(1, sizeof(Tracer));
+
+	if (!t)
+		return 0;
+
+	t->block_size = TRACE_BLOCK_SIZE;
+	t->blocks = size / TRACE_BLOCK_SIZE;
+	if (t->blocks < 2)
+		t->blocks = 2;
+
+	t->ring = (u8*) malloc(t->blocks * t->block_size);
+	if (!t->ring) {
+		free(t);
+		return 0;
+	}
+	return t;
+}
+
+
+void
+free_tracer(Tracer* t)
+{
+	if (!t)
+		return;
+	free(t->ring);
+	free(t);
+}
+
+
+/*
+	Start:
+		Called as interpret starts. Offsets are only meaningful within a
+		process, so a context that has been given another since the last
+		run starts on a fresh block from where it is now.
+*/
+void
+trace_start(Tracer* t, Process* pro, u8* stk, u8* ip, u8* sp)
+{
+	if (t->block && t->img == pro->img && t->stk == stk)
+		return;
+
+	t->img = pro->img;
+	t->stk = stk;
+	t->last_ip = ip;
+	t->last_sp = sp;
+	trace_block(t);
+}
+
+
+// Begins the next block in the ring, over the oldest once it's full.
+void
+trace_block(Tracer* t)
+{
+	TraceBlock* b = (TraceBlock*) (t->ring + (t->written % t->blocks) * t->block_size);
+
+	b->ip = t->last_ip - t->img;
+	b->sp = t->last_sp - t->stk;
+	b->size = 0;
+	b->records = 0;
+
+	t->block = b;
+	t->p     = (u8*) (b + 1);
+	t->end   = (u8*) b + t->block_size;
+	++t->written;
+}
+
+
+int
+trace_write(Tracer* t, const char* path)
+{
+	FILE* f = fopen(path, "wb");
+	u64 kept = (t->written < t->blocks) ? t->written : t->blocks;
+	u64 dropped = t->written - kept;
+	u8  version = TRACE_VERSION;
+	u64 i;
+
+	if (!f)
+		return -1;
+
+	fwrite(TRACE_MAGIC, 1, 4, f);
+	fwrite(&version, 1, 1, f);
+	fwrite(&t->block_size, sizeof(u64), 1, f);
+	fwrite(&kept, sizeof(u64), 1, f);
+	fwrite(&dropped, sizeof(u64), 1, f);
+	for (i=dropped; i < t->written; ++i)
+		fwrite(t->ring + (i % t->blocks) * t->block_size, 1, t->block_size, f);
+	return fclose(f);
+}
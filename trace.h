@@ -0,0 +1,100 @@
+#ifndef trace_h
+#define trace_h
+
+#include "tyson.h"
+
+#define TRACE_MAGIC         "TYTR"
+#define TRACE_VERSION       (1)
+#define TRACE_BLOCK_SIZE    (64 * 1024)
+#define TRACE_DEFAULT_SIZE  (64 * 1024 * 1024)
+
+// Biggest record, an opcode and two 10 byte varints.
+#define TRACE_RECORD_MAX    (21)
+
+/*
+	Trace Block:
+		The ring is made of fixed size blocks, each starting with one of
+		these giving where the context was at the dispatch before its
+		first record, so a block decodes without the ones before it and
+		the oldest can be overwritten once the ring is full.
+*/
+typedef struct {
+	u64 ip;      // img offset.
+	s64 sp;      // bytes above stk.
+	u32 size;    // bytes of records following.
+	u32 records;
+} TraceBlock;
+
+/*
+	Tracer:
+		Records every instruction a context dispatches into an in-memory
+		ring, for tytrace.py to rebuild the instruction stream from. While
+		a context has one it runs on the tracing table, which records then
+		goes on to the profiling entry or the optable, so contexts without
+		one run exactly as before.
+
+		A record is the opcode followed by how far ip and sp moved since
+		the last dispatch, zigzagged LEB128 varints. Straight-line code
+		moves ip by the last instruction's length, so most records are
+		three bytes, and a taken branch shows as any other distance.
+
+		trace_write dumps the ring oldest block first: TRACE_MAGIC, u8
+		version, then u64 block size, block count and blocks dropped to
+		the ring wrapping, then the blocks. PLSTART workers aren't traced.
+*/
+struct Tracer {
+	u8*  ring;
+	u64  block_size;
+	u64  blocks;   // in the ring.
+	u64  written;  // blocks begun, ever.
+	TraceBlock* block; // being written.
+	u8*  p;        // write cursor within it.
+	u8*  end;
+	u8*  img;      // bases offsets are taken from.
+	u8*  stk;
+	u8*  last_ip;  // at the dispatch before.
+	u8*  last_sp;
+};
+
+Tracer* new_tracer(u64);
+void    free_tracer(Tracer*);
+void    trace_start(Tracer*, Process*, u8*, u8*, u8*);
+void    trace_block(Tracer*);
+int     trace_write(Tracer*, const char*);
+
+
+static inline u8*
+trace_uleb(u8* p, u64 value)
+{
+	while (value >= 0x80) {
+		*p++ = (u8) value | 0x80;
+		value >>= 7;
+	}
+	*p++ = (u8) value;
+	return p;
+}
+
+
+// Called on every dispatch, before the instruction at ip runs.
+static inline void
+trace_record(Tracer* t, u8* ip, u8* sp)
+{
+	s64 dip = ip - t->last_ip;
+	s64 dsp = sp - t->last_sp;
+	u8* p;
+
+	if (t->end - t->p < TRACE_RECORD_MAX)
+		trace_block(t);
+
+	p = t->p;
+	*p++ = *ip;
+	p = trace_uleb(p, ((u64) dip << 1) ^ (u64) (dip >> 63));
+	p = trace_uleb(p, ((u64) dsp << 1) ^ (u64) (dsp >> 63));
+	t->block->size += p - t->p;
+	++t->block->records;
+	t->p = p;
+	t->last_ip = ip;
+	t->last_sp = sp;
+}
+
+#endif
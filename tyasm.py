@@ -1,3 +1,4 @@
+import os
 import sys
 from tyson import *
 
@@ -171,6 +172,10 @@ class Metadata:
 		self.heap_size  = u64(heap_size)
 		self.args_count = u64(0)
 		self.args_size  = u64(0)
+		self.export_base = u64(0)
+		self.export_size = u64(0)
+		self.debug_base = u64(0)
+		self.debug_size = u64(0)
 						
 	def byte_len(self):
 		return METADATA_SIZE
@@ -207,12 +212,99 @@ class Metadata:
 			string.append(byte)
 		for byte in bytes(self.args_size):
 			string.append(byte)
+		for byte in bytes(self.export_base):
+			string.append(byte)
+		for byte in bytes(self.export_size):
+			string.append(byte)
+		for byte in bytes(self.debug_base):
+			string.append(byte)
+		for byte in bytes(self.debug_size):
+			string.append(byte)
+		return bytes(string)
+
+class ExportTable:
+	def __init__(self):
+		self.entries = []
+
+	def new_export(self, name, addr):
+		self.entries.append((name, addr))
+
+	def __len__(self):
+		return len(self.entries)
+
+	def byte_len(self):
+		return len(bytes(self))
+
+	def __repr__(self):
+		return 'ExportTable({})'.format(repr(self.entries))
+
+	def __bytes__(self):
+		string = bytearray()
+		for byte in bytes(u64(len(self.entries))):
+			string.append(byte)
+		for name, addr in self.entries:
+			for byte in bytes(u64(addr)):
+				string.append(byte)
+			for ch in name:
+				string.append(ord(ch))
+			string.append(0)
+		return bytes(string)
+
+# labels, source lines and symbols for the debugger and typrof.py, see dbinfo.h for the layout.
+class DebugInfo:
+	def __init__(self, source=''):
+		self.source  = source
+		self.labels  = []
+		self.lines   = []
+		self.symbols = []
+
+	def new_label(self, name, addr):
+		self.labels.append((name, addr))
+
+	def new_line(self, addr, line):
+		self.lines.append((addr, line))
+
+	def new_symbol(self, name, dtype, value):
+		self.symbols.append((name, dtype, value))
+
+	def __len__(self):
+		return len(self.labels) + len(self.lines) + len(self.symbols)
+
+	def byte_len(self):
+		return len(bytes(self))
+
+	def __repr__(self):
+		return 'DebugInfo({}, {}, {})'.format(repr(self.labels), repr(self.lines), repr(self.symbols))
+
+	def __bytes__(self):
+		string = bytearray(DEBUG_MAGIC)
+		string.append(DEBUG_VERSION)
+		name = self.source.encode()
+		string += uleb(len(name)) + name
+		string += uleb(len(self.labels))
+		last = 0
+		for name, addr in sorted(self.labels, key=lambda label: label[1]):
+			name = name.encode()
+			string += uleb(addr - last) + uleb(len(name)) + name
+			last = addr
+		string += uleb(len(self.lines))
+		last = last_line = 0
+		for addr, line in sorted(self.lines):
+			string += uleb(addr - last) + sleb(line - last_line)
+			last, last_line = addr, line
+		string += uleb(len(self.symbols))
+		for name, dtype, value in self.symbols:
+			name = name.encode()
+			string.append(dtype)
+			string += sleb(value) + uleb(len(name)) + name
 		return bytes(string)
 
 class TextImage:
-	def __init__(self, metadata=None, instrs=None):
+	def __init__(self, metadata=None, instrs=None, exports=None, debug=None):
 		self.metadata = metadata
 		self.instrs   = instrs
+		self.exports  = exports
+		self.debug    = debug
 
 	def __len__(self):
 		return len(bytes(self))
@@ -226,6 +318,12 @@ class TextImage:
 			string.append(byte)
 		for byte in bytes(self.instrs):
 			string.append(byte)
+		if self.exports is not None and len(self.exports):
+			for byte in bytes(self.exports):
+				string.append(byte)
+		if self.debug is not None and len(self.debug):
+			for byte in bytes(self.debug):
+				string.append(byte)
 		return bytes(string)
 
 	def write(self, path):
@@ -244,7 +342,8 @@ class symbol:
 class assembler:
 	def __repr__(self):
 		return ''
-	def __init__(self, in_path=None, out_path=None, report=True):
+	def __init__(self, in_path=None, out_path=None, report=True, debug=False):
+		self.debug = debug
 		if in_path is not None and out_path is not None:
 			self.assemble(in_path, out_path, report)
 
@@ -252,11 +351,16 @@ class assembler:
 		self.in_path = in_path
 		self.out_path = out_path
 		self.instrs = InstrList()
-		self.symbols = []
+		self.symbols = [symbol(name, U64, index) for name, index in native_map.items()]
+		self.symbols += [symbol(name, U64, code) for name, code in fopen_symbols.items()]
+		self.symbols += [symbol(name, U64, code) for name, code in type_symbols.items()]
+		self.builtin_symbols = len(self.symbols)
 		self.start_addr = TEXT_BASE	
 		self.lcount = 0
 		self.heap_size = 0
 		self.pool_size = 0
+		self.exports = []
+		self.line_table = []
 
 	def user_report(self):
 		print('\t{} instructions({} bytes) - total image size: {} bytes.'.format(str(len(self.instrs)), str(len(self.image)-METADATA_SIZE), str(len(self.image))))
@@ -391,7 +495,7 @@ class assembler:
 		self.i += 1
 		self.tok = self.words[self.i]
 		try:
-			self.heapsize = int(self.tok)
+			self.heap_size = int(self.tok)
 			return True
 		except:
 			print('\n\tinvalid arg to heapsize directive, on line {}.'.format(self.lcount))
@@ -429,6 +533,40 @@ class assembler:
 		self.symbols.append(sym)
 		return True
 
+	def new_export(self):
+		self.i += 1
+		try:
+			self.tok = self.words[self.i]
+		except:
+			print('\n\texport directive needs a label, on line {}.'.format(self.lcount))
+			return False
+		if self.tok in self.exports:
+			print('\n\talready exported {}, on line {}.'.format(self.tok, self.lcount))
+			return False
+		self.exports.append(self.tok)
+		return True
+
+	def build_exports(self):
+		table = ExportTable()
+		for name in self.exports:
+			if name not in self.labels.keys():
+				print('\n\tno label by the name of {} to export.'.format(name))
+				return None
+			table.new_export(name, self.labels[name])
+		return table
+
+	def build_debug_info(self):
+		info = DebugInfo(os.path.abspath(self.in_path))
+		if not self.debug:
+			return info
+		for name, addr in self.labels.items():
+			info.new_label(name, addr)
+		for addr, line in self.line_table:
+			info.new_line(addr, line)
+		for sym in self.symbols[self.builtin_symbols:]:
+			info.new_symbol(sym.name, sym.dtype, sym.value)
+		return info
+
 	def build_image(self):
 		try:
 			self.lines = open(self.in_path, 'r').readlines()
@@ -453,6 +591,10 @@ class assembler:
 					if self.new_symbol() == False:
 						return
 					break
+				elif self.tok == 'export':
+					if self.new_export() == False:
+						return
+					break
 				elif self.tok == 'start:':
 					self.start_addr = self.instrs.next_addr()
 					self.labels['start'] = self.instrs.next_addr()
@@ -461,6 +603,7 @@ class assembler:
 					continue
 				elif self.tok in opmap.keys():
 					self.opcode = from_opname(self.tok)
+					self.line_table.append((self.instrs.next_addr(), self.lcount))
 					if self.opcode in no_arg_ops:
 						self.instrs.new_instr(self.instrs.next_addr(), self.opcode)
 						continue
@@ -503,7 +646,17 @@ class assembler:
 					print('\n\tout of place token on line {}'.format(self.lcount))
 					raise Exception()
 		self.metadata = Metadata(self.instrs.byte_len(), self.start_addr, self.pool_size, self.heap_size)
-		self.image = TextImage(self.metadata, self.instrs)
+		self.export_table = self.build_exports()
+		if self.export_table is None:
+			raise Exception()
+		if len(self.export_table):
+			self.metadata.export_base = u64(int(self.metadata.timg_size))
+			self.metadata.export_size = u64(self.export_table.byte_len())
+		self.debug_info = self.build_debug_info()
+		if len(self.debug_info):
+			self.metadata.debug_base = u64(int(self.metadata.timg_size) + int(self.metadata.export_size))
+			self.metadata.debug_size = u64(self.debug_info.byte_len())
+		self.image = TextImage(self.metadata, self.instrs, self.export_table, self.debug_info)
 
 	def find_labels(self):
 		self.labels = {}
@@ -530,6 +683,8 @@ class assembler:
 					if self.new_symbol() == False:
 						return
 					break
+				elif self.tok == 'export':
+					break
 				elif self.tok == 'start:':
 					self.start_addr = self.instrs.next_addr()
 					self.labels['start'] = self.instrs.next_addr()
@@ -583,12 +738,13 @@ class assembler:
 					print('\n\tout of place token on line {}'.format(self.lcount))
 					raise Exception()
 
+# tyasm.py <in.tys> <out.tpx> <report> [-g], -g adds debug info for the debugger and typrof.py.
 if __name__ == '__main__':
-	if len(sys.argv) == 4:
+	if len(sys.argv) == 4 or (len(sys.argv) == 5 and sys.argv[4] == '-g'):
 		in_path = str(sys.argv[1])
 		out_path = str(sys.argv[2])
 		report = bool(sys.argv[3])
-		assembler(in_path, out_path, report)
+		assembler(in_path, out_path, report, len(sys.argv) == 5)
 		quit()
 	else:
 		print('\n\tinvalid input to assembler.')
@@ -0,0 +1,104 @@
+import os
+import sys
+import struct
+from bisect import bisect_right
+from tyson import *
+
+# typrof.py <image.tpx> <samplefile> [source.tys]
+#   reports where the samples taken by tyson -s fell, per label and per source line,
+#   using the debug info tyasm.py -g puts in the image, source.tys defaults to the file it was assembled from.
+
+class DebugInfo:
+	def __init__(self, path):
+		self.source = ''
+		self.labels = []
+		self.lines  = []
+		image = open(path, 'rb').read()
+		base, size = struct.unpack_from('<QQ', image, DEBUG_BASE_OFFS)
+		data = image[base:base + size]
+		if not size or data[:4] != DEBUG_MAGIC or data[4] != DEBUG_VERSION:
+			return
+		length, i = read_uleb(data, 5)
+		self.source = data[i:i + length].decode()
+		i += length
+		count, i = read_uleb(data, i)
+		addr = 0
+		for _ in range(count):
+			delta, i = read_uleb(data, i)
+			length, i = read_uleb(data, i)
+			addr += delta
+			self.labels.append((addr, data[i:i + length].decode()))
+			i += length
+		count, i = read_uleb(data, i)
+		addr = line = 0
+		for _ in range(count):
+			delta, i = read_uleb(data, i)
+			step, i = read_sleb(data, i)
+			addr += delta
+			line += step
+			self.lines.append((addr, line))
+		self.label_addrs = [addr for addr, name in self.labels]
+		self.line_addrs  = [addr for addr, line in self.lines]
+
+	# the last label or line at or before addr.
+	def label(self, addr):
+		k = bisect_right(self.label_addrs, addr) - 1
+		return self.labels[k][1] if k >= 0 else '?'
+
+	def line(self, addr):
+		k = bisect_right(self.line_addrs, addr) - 1
+		return self.lines[k][1] if k >= 0 else 0
+
+def read_samples(path):
+	samples = []
+	for text in open(path, 'r'):
+		frames = [int(word) for word in text.split()]
+		if frames:
+			samples.append(frames)
+	return samples
+
+# a return address is the byte after the call, its caller is the call itself.
+def sample_labels(info, frames):
+	return [info.label(frames[0])] + [info.label(addr - 1) for addr in frames[1:]]
+
+def report(image_path, sample_path, source_path=None):
+	info = DebugInfo(image_path)
+	if not info.labels:
+		print('\n\t{} has no debug info, assemble it with -g.'.format(image_path))
+		return
+	samples = read_samples(sample_path)
+	if not samples:
+		print('\n\tno samples in {}.'.format(sample_path))
+		return
+	if source_path is None and os.path.exists(info.source):
+		source_path = info.source
+	source = open(source_path, 'r').readlines() if source_path else None
+
+	self_time = {}
+	incl_time = {}
+	line_time = {}
+	for frames in samples:
+		names = sample_labels(info, frames)
+		self_time[names[0]] = self_time.get(names[0], 0) + 1
+		for name in set(names):
+			incl_time[name] = incl_time.get(name, 0) + 1
+		line = info.line(frames[0])
+		line_time[line] = line_time.get(line, 0) + 1
+
+	total = len(samples)
+	print('\n\t{} samples.\n'.format(total))
+	print('\t{:>7} {:>8} {:>7} {:>8}  {}'.format('self%', 'self', 'incl%', 'incl', 'label'))
+	for name in sorted(incl_time, key=lambda name: (-self_time.get(name, 0), -incl_time[name])):
+		print('\t{:>7.2f} {:>8} {:>7.2f} {:>8}  {}'.format(100.0 * self_time.get(name, 0) / total, self_time.get(name, 0),
+		                                                  100.0 * incl_time[name] / total, incl_time[name], name))
+
+	print('\n\t{:>7} {:>8}  {}'.format('self%', 'self', 'line'))
+	for line in sorted(line_time, key=lambda line: -line_time[line])[:20]:
+		text = source[line - 1].strip() if source and 0 < line <= len(source) else ''
+		print('\t{:>7.2f} {:>8}  {:<6} {}'.format(100.0 * line_time[line] / total, line_time[line], line, text))
+
+if __name__ == '__main__':
+	if len(sys.argv) in (3, 4):
+		report(*sys.argv[1:])
+	else:
+		print('\n\tinvalid input to typrof.')
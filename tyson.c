@@ -3,13 +3,33 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 
 #include "tyson.h"
 #include "opcodes.h"
 #include "debug.h"
+#include "batch.h"
+#include "native.h"
+#include "fileio.h"
+#include "aio.h"
+#include "output.h"
+#include "heap.h"
+#include "lstr.h"
+#include "strk.h"
+#include "reduce.h"
+#include "bulk.h"
+#include "hmap.h"
+#include "sort.h"
+#include "profile.h"
+#include "sample.h"
+#include "dbinfo.h"
+#include "trace.h"
 
 #define next_op() \
-	goto *optable[*ip]
+	goto *dispatch[*ip]
 
 #define stack_byte(offset) \
 	(sp - offset)
@@ -20,61 +40,105 @@
 #define sp_offset() \
 	((u64) (sp - stk))
 
+// Raises the stack high-water marks, see Usage in tyson.h.
+#define note_depth()       \
+	{	if (sp > sp_peak)  \
+			sp_peak = sp;  \
+		if (rp > rp_peak)  \
+			rp_peak = rp;  \
+	}
+
 
 // VM compilation mode is specified by the macro below.
-// Set to DEBUG_MODE or REAL_MODE.
+// Set to DEBUG_MODE or REAL_MODE, library builds are always REAL_MODE,
+// and -DREAL_MODE picks it without editing this, as bench/run.py needs.
+#if !defined(TYSON_LIB) && !defined(REAL_MODE)
 #define DEBUG_MODE
-
-#ifdef DEBUG_MODE
-	#define next_cycle()           \
-    {	if (db_mode==STEP) {       \
-            switch (cycact) {      \
-                case 1:            \
-                    cycact = 2;    \
-                    next_op();     \
-                case 2:            \
-                    cycact = 1;    \
-                    goto db_start; \
-            }                      \
-		} else {                   \
-			next_op();             \
-		}                          \
-    }
-#else
-	#define next_cycle() \
-		next_op()
 #endif
 
+// The debugger steps and breaks by what dispatch points at, never by a check here.
+#define next_cycle() \
+	next_op()
 
-int
-execute_process(Process* pro)
+
+static int  run_ploop(VMContext*, u8*, u8*, u8*, u64, s64, u64*, u64);
+
+/*
+	Interpret:
+		The interpreter proper. Registers are loaded from the context into
+		locals on entry and saved back to it on the way out, so a context
+		can be run again from wherever it stopped.
+
+		EXEC_RUN runs until the process dies, PLSTART worker contexts
+		(vm->slice) return as soon as their slice of the loop finishes.
+		EXEC_STEP executes exactly one instruction: it is dispatched
+		straight from the optable and every dispatch after it lands on the
+		trap table, which halts with VM_STEPPED.
+
+		A context with a Profile runs on the profiling table instead, every
+		entry of which ticks the profile before going on to the optable,
+		and one with a Sampler on the sampling table, which takes any
+		sample that's due then goes on to the tracing entry, the
+		profiling entry or the optable. One with a Tracer but no Sampler
+		starts on the tracing table. One with none of those but depth set
+		runs on the depth table, which only raises the stack high-water
+		marks before going on to the optable.
+
+		The DEBUG_MODE debugger works the same way. Stepping dispatches
+		one instruction from the context's table with dispatch on the
+		debug trap table, which lands back in db_start. Running puts
+		dispatch back and patches the breakpoints into the text, see
+		debug.h. Only a step writes a trace line, running costs nothing
+		but the table swaps, so until a breakpoint is reached the process
+		runs as fast as it would in a build without the debugger.
+*/
+static int
+interpret(VMContext* vm, u8 mode)
 {
 	build_optable();
-	
-	int retval = 0;
+	static void* const traptable[OPCOUNT] = {[0 ... OPCOUNT-1] = &&trap};
+	static void* const proftable[OPCOUNT] = {[0 ... OPCOUNT-1] = &&prof};
+	static void* const samptable[OPCOUNT] = {[0 ... OPCOUNT-1] = &&samp};
+	static void* const tracetable[OPCOUNT] = {[0 ... OPCOUNT-1] = &&trace};
+	static void* const depthtable[OPCOUNT] = {[0 ... OPCOUNT-1] = &&depth};
+	void* const* run_table = vm->samp ? samptable :
+	                         vm->trace ? tracetable :
+	                         vm->prof ? proftable :
+	                         vm->depth ? depthtable : optable;
+	void* const* dispatch = (mode == EXEC_STEP) ? traptable : run_table;
+
+	int retval = VM_DIED;
 
-	// Initialise work stack.
-	u8  stk[STACK_SIZE]; // array.
-	u8* sp = stk; // stack-pointer.
+	Process* pro = vm->pro;
 
-	// Initialise return stack.
-	u8* rstk[RECUR_LIMIT]; // pointer-array.
-	u8** rp = rstk;        // return-pointer.
-	*rstk = img_byte(TEXT_BASE);
+	// Work stack.
+	u8* stk = vm->stk; // array.
+	u8* sp  = vm->sp;  // stack-pointer.
+
+	// Return stack.
+	u8** rstk = vm->rstk; // pointer-array.
+	u8** rp   = vm->rp;   // return-pointer.
 	
-	// Initialise instruction-pointer.
-	u8*  ip = pro->start_byte;
+	// Instruction-pointer.
+	u8*  ip = vm->ip;
+
+	// Loop vars.
+	u8*  lp_cont  = vm->lp_cont;
+	u8*  lp_stop  = vm->lp_stop;
+	u64  lp_count = vm->lp_count;
 
-	// Declare loop vars
-	u8*  lp_cont;
-	u8*  lp_stop;
-	u64  lp_count;
+	// Table pointer.
+	u8*  tdx = vm->tdx;
 
-	// Declare table pointer.
-	u8*  tdx;
+	// Instruction the sampling table last passed on, the one a due sample lands in.
+	u8*  samp_ip = ip;
 
-	// Declare fast-jump pointers.
-	u8 *c1, *c2, *c3, *c4;
+	// Deepest the stacks have been, kept in the process while halted.
+	u8*  sp_peak = stk + pro->usage.stk_peak;
+	u8** rp_peak = rstk + pro->usage.rstk_peak;
+
+	// Fast-jump pointers.
+	u8 *c1 = vm->c1, *c2 = vm->c2, *c3 = vm->c3, *c4 = vm->c4;
 	
 	// Internal data pointers.
 	word *Wp1, *Wp2, *Wp3;
@@ -86,18 +150,35 @@ execute_process(Process* pro)
 
 	// Internal buffers for use by currently executing instr.
 	// Each instr must init these itself, cleanup not required.
-	u8  dbuf[DATABUF_SIZE];
+	u8* dbuf = vm->dbuf;
 	u64 c; // general purpose counter.
 
 	#ifdef DEBUG_MODE
 	// Set up debug-mode variables.
 	build_dbtable();
-    u8  db_mode = STEP;
+	static void* const dbtraptable[OPCOUNT] = {[0 ... OPCOUNT-1] = &&db_trap};
+	static void* const dbrearmtable[OPCOUNT] = {[0 ... OPCOUNT-1] = &&db_rearm};
+	u8* db_skip = ip; // breakpoint left out while its own instruction runs.
+	int db_op;
 	u64 cycnum  = 0;
-    u8  cycact  = 1;
     u64 addr;
     u8* str;
     u8  *a, *b;
+	#endif
+
+	if (vm->prof)
+		prof_start(vm->prof);
+	if (vm->samp && mode != EXEC_STEP)
+		sampler_arm(vm->samp);
+	if (vm->trace)
+		trace_start(vm->trace, pro, stk, ip, sp);
+
+	if (mode == EXEC_STEP)
+		goto *optable[*ip];
+
+	#ifdef DEBUG_MODE
+	if (vm->slice || !pro->debug)
+		next_op();
     goto db_start;
 	#else
 	// VM has been initialised and is ready to call the process' main subroutine.
@@ -106,52 +187,37 @@ execute_process(Process* pro)
 
   	// Instruction Blocks.
 	die:
+		up1 = (u64*) sp;
+		pro->result = *up1;
+		flush_files(pro->files);
 		#ifdef DEBUG_MODE
-		++cycnum;
+		if (vm->slice || !pro->debug)
+			goto halt;
 		goto db_start;
 		#else
-		return retval;
+		goto halt;
 		#endif
 	nop:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tNOP executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip; // point ip at next opcode in sequence.
 		next_cycle();
 	jmp:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tJMP executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip; // point ip at first arg, jump-target address.
 		up1 = (u64*) ip; // get u64 pointer to said arg.
 		ip = img_byte(*up1); // set ip at jump-target.
 		next_cycle();
 	call:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tCALL executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++rp; // inc ret-pointer so ret-stack is ready for push.
+		note_depth();
 		++ip; // point ip at first arg, jump-target address.
 		*rp = ip + wordsize; // set rp to the first byte after this instr, the ret address.
 		up1 = (u64*) ip; // get u64 pointer to jump-target.
 		ip = img_byte(*up1); // set ip to jump-target.
 		next_cycle();
 	ret:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tRET executed on cycle %u", (unsigned) cycnum);
-		#endif
 		ip = *rp; // set ip to current return address, top of ret-stack.
 		--rp; // dec rp so top of ret-stack is the correct ret adress.
 		next_cycle();
 	swch:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSWCH executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip; // point ip at jump-tbl base.
 		up1 = (u64*) sp; // get pointer to index value.
 		sp -= wordsize; // swch auto-pops jump-tbl index value off top.
@@ -159,10 +225,6 @@ execute_process(Process* pro)
 		ip = img_byte(*up2); // set ip to target address then execute next.
 		next_cycle();
 	jeq_b:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nJEQ_B executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		bp1 = sp;
 		bp2 = sp - wordsize;
@@ -174,10 +236,6 @@ execute_process(Process* pro)
 		}
 		next_cycle();
 	jneq_b:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nJNEQ_B executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		bp1 = sp;
 		bp2 = sp - wordsize;
@@ -189,10 +247,6 @@ execute_process(Process* pro)
 		}
 		next_cycle();
 	jeq_w:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nJEQ_W executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		wp1 = (w64*) sp;
 		wp2 = (w64*) (sp - wordsize);
@@ -204,10 +258,6 @@ execute_process(Process* pro)
 		}
 		next_cycle();
 	jneq_w:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nJNEQ_W executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		wp1 = (w64*) sp;
 		wp2 = (w64*) (sp - wordsize);
@@ -219,10 +269,6 @@ execute_process(Process* pro)
 		}
 		next_cycle();
 	jgeq_b:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nJGEQ_B executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		bp1 = sp;
 		bp2 = sp - wordsize;
@@ -234,10 +280,6 @@ execute_process(Process* pro)
 		}
 		next_cycle();
 	jleq_b:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nJLEQ_B executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		bp1 = sp;
 		bp2 = sp - wordsize;
@@ -249,10 +291,6 @@ execute_process(Process* pro)
 		}
 		next_cycle();
 	jgt_b:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nJGT_B executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		bp1 = sp;
 		bp2 = sp - wordsize;
@@ -264,10 +302,6 @@ execute_process(Process* pro)
 		}
 		next_cycle();
 	jlt_b:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nJLT_B executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		bp1 = sp;
 		bp2 = sp - wordsize;
@@ -279,10 +313,6 @@ execute_process(Process* pro)
 		}
 		next_cycle();
 	jgeq_u:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nJGEQ_U executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) sp;
 		up2 = (u64*) (sp - wordsize);
@@ -294,10 +324,6 @@ execute_process(Process* pro)
 		}
 		next_cycle();
 	jleq_u:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nJLEQ_U executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) sp;
 		up2 = (u64*) (sp - wordsize);
@@ -309,10 +335,6 @@ execute_process(Process* pro)
 		}
 		next_cycle();
 	jgt_u:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nJGT_U executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) sp;
 		up2 = (u64*) (sp - wordsize);
@@ -324,10 +346,6 @@ execute_process(Process* pro)
 		}
 		next_cycle();
 	jlt_u:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nJLT_U executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) sp;
 		up2 = (u64*) (sp - wordsize);
@@ -339,10 +357,6 @@ execute_process(Process* pro)
 		}
 		next_cycle();
 	jgeq_i:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nJGEQ_I executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		ip1 = (s64*) sp;
 		ip2 = (s64*) (sp - wordsize);
@@ -354,10 +368,6 @@ execute_process(Process* pro)
 		}
 		next_cycle();
 	jleq_i:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nJLEQ_I executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		ip1 = (s64*) sp;
 		ip2 = (s64*) (sp - wordsize);
@@ -369,10 +379,6 @@ execute_process(Process* pro)
 		}
 		next_cycle();
 	jgt_i:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nJGT_I executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		ip1 = (s64*) sp;
 		ip2 = (s64*) (sp - wordsize);
@@ -384,10 +390,6 @@ execute_process(Process* pro)
 		}
 		next_cycle();
 	jlt_i:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nJGT_I executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		ip1 = (s64*) sp;
 		ip2 = (s64*) (sp - wordsize);
@@ -399,10 +401,6 @@ execute_process(Process* pro)
 		}
 		next_cycle();
 	jgeq_r:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nJGEQ_R executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		rp1 = (r64*) sp;
 		rp2 = (r64*) (sp - wordsize);
@@ -414,10 +412,6 @@ execute_process(Process* pro)
 		}
 		next_cycle();
 	jleq_r:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tJLEQ_R executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		rp1 = (r64*) sp;
 		rp2 = (r64*) (sp - wordsize);
@@ -429,10 +423,6 @@ execute_process(Process* pro)
 		}
 		next_cycle();
 	jgt_r:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tJGT_R executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		rp1 = (r64*) sp;
 		rp2 = (r64*) (sp - wordsize);
@@ -444,10 +434,6 @@ execute_process(Process* pro)
 		}
 		next_cycle();
 	jlt_r:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tJGT_R executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		rp1 = (r64*) sp;
 		rp2 = (r64*) (sp - wordsize);
@@ -459,78 +445,42 @@ execute_process(Process* pro)
 		}
 		next_cycle();
 	jmp_c1:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tJMP_C1 executed on cycle %u", (unsigned) cycnum);
-		#endif
 		ip = c1;
 		next_cycle();
 	jmp_c2:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tJMP_C2 executed on cycle %u", (unsigned) cycnum);
-		#endif
 		ip = c2;
 		next_cycle();
 	jmp_c3:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tJMP_C3 executed on cycle %u", (unsigned) cycnum);
-		#endif
 		ip = c3;
 		next_cycle();
 	jmp_c4:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tJMP_C4 executed on cycle %u", (unsigned) cycnum);
-		#endif
 		ip = c3;
 		next_cycle();
 	set_c1:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSET_C1 executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		c1 = img_byte(*up1);
 		ip += wordsize;
 		next_cycle();
 	set_c2:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSET_C2 executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		c2 = img_byte(*up1);
 		ip += wordsize;
 		next_cycle();
 	set_c3:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSET_C3 executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		c3 = img_byte(*up1);
 		ip += wordsize;
 		next_cycle();
 	set_c4:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSET_C4 executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		c4 = img_byte(*up1);
 		ip += wordsize;
 		next_cycle();
 	eq:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tEQ executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		wp1 = (w64*) sp;
 		wp2 = (w64*) (sp - wordsize);
@@ -542,10 +492,6 @@ execute_process(Process* pro)
 			*up1 = FALSE;
 		next_cycle();
 	neq:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tNEQ executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		wp1 = (w64*) sp;
 		wp2 = (w64*) (sp - wordsize);
@@ -557,10 +503,6 @@ execute_process(Process* pro)
 			*up1 = FALSE;
 		next_cycle();
 	and:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tAND executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		wp1 = (w64*) sp;
 		wp2 = (w64*) (sp - wordsize);
@@ -569,10 +511,6 @@ execute_process(Process* pro)
 		*wp3 = ((*wp1) & (*wp2));
 		next_cycle();
 	not:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tOR executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		wp1 = (w64*) sp;
 		sp -= wordsize;
@@ -580,10 +518,6 @@ execute_process(Process* pro)
 		*wp2 = !(*wp1);
 		next_cycle();
 	or:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tOR executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		wp1 = (w64*) sp;
 		wp2 = (w64*) (sp - wordsize);
@@ -592,10 +526,6 @@ execute_process(Process* pro)
 		*wp3 = ((*wp1) | (*wp2));
 		next_cycle();
 	xor:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tXOR executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		wp1 = (w64*) sp;
 		wp2 = (w64*) (sp - wordsize);
@@ -604,10 +534,6 @@ execute_process(Process* pro)
 		*wp3 = ((*wp1) ^ (*wp2));
 		next_cycle();
 	lsh:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tLSH executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		wp1 = (w64*) sp;
 		wp2 = (w64*) (sp - wordsize);
@@ -616,10 +542,6 @@ execute_process(Process* pro)
 		*wp3 = ((*wp1) << (*wp2));
 		next_cycle();
 	rsh:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tRSH executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		wp1 = (w64*) sp;
 		wp2 = (w64*) (sp - wordsize);
@@ -628,62 +550,34 @@ execute_process(Process* pro)
 		*wp3 = ((*wp1) >> (*wp2));
 		next_cycle();
 	inc_b:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tINC_B executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		++(*sp);
 		next_cycle();
 	inc_u:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tINC_U executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) sp;
 		++(*up1);
 		next_cycle();
 	inc_i:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tINC_I executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		ip1 = (s64*) sp;
 		++(*ip1);
 		next_cycle();
 	dec_b:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tDEC_B executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		--(*sp);
 		next_cycle();
 	dec_u:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tDEC_U executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) sp;
 		--(*up1);
 		next_cycle();
 	dec_i:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tDEC_I executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		ip1 = (s64*) sp;
 		--(*ip1);
 		next_cycle();
 	add_b:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tADD_B executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		bp1 = sp;
 		bp2 = (sp - wordsize);
@@ -691,10 +585,6 @@ execute_process(Process* pro)
 		*sp = ((*bp1) + (*bp2));
 		next_cycle();
 	add_u:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tADD_U executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) sp;
 		up2 = (u64*) (sp - wordsize);
@@ -703,10 +593,6 @@ execute_process(Process* pro)
 		*up3 = ((*up1) + (*up2));
 		next_cycle();
 	add_i:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tADD_I executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		ip1 = (s64*) sp;
 		ip2 = (s64*) (sp - wordsize);
@@ -715,10 +601,6 @@ execute_process(Process* pro)
 		*ip3 = ((*ip1) + (*ip2));
 		next_cycle();
 	add_r:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tADD_R executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		rp1 = (r64*) sp;
 		rp2 = (r64*) (sp - wordsize);
@@ -727,10 +609,6 @@ execute_process(Process* pro)
 		*rp3 = ((*rp1) + (*rp2));
 		next_cycle();
 	sub_b:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSUB_B executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		bp1 = sp;
 		bp2 = (sp - wordsize);
@@ -738,10 +616,6 @@ execute_process(Process* pro)
 		*sp = ((*bp1) - (*bp2));
 		next_cycle();
 	sub_u:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSUB_U executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) sp;
 		up2 = (u64*) (sp - wordsize);
@@ -750,10 +624,6 @@ execute_process(Process* pro)
 		*up3 = ((*up1) - (*up2));
 		next_cycle();
 	sub_i:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSUB_I executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		ip1 = (s64*) sp;
 		ip2 = (s64*) (sp - wordsize);
@@ -762,10 +632,6 @@ execute_process(Process* pro)
 		*ip3 = ((*ip1) - (*ip2));
 		next_cycle();
 	sub_r:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSUB_R executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		rp1 = (r64*) sp;
 		rp2 = (r64*) (sp - wordsize);
@@ -774,10 +640,6 @@ execute_process(Process* pro)
 		*rp3 = ((*rp1) - (*rp2));
 		next_cycle();
 	mul_b:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tMUL_B executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		bp1 = sp;
 		bp2 = (sp - wordsize);
@@ -785,10 +647,6 @@ execute_process(Process* pro)
 		*sp = ((*bp1) * (*bp2));
 		next_cycle();
 	mul_u:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tMUL_U executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) sp;
 		up2 = (u64*) (sp - wordsize);
@@ -797,10 +655,6 @@ execute_process(Process* pro)
 		*up3 = ((*up1) * (*up2));
 		next_cycle();
 	mul_i:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tMUL_I executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		ip1 = (s64*) sp;
 		ip2 = (s64*) (sp - wordsize);
@@ -809,10 +663,6 @@ execute_process(Process* pro)
 		*ip3 = ((*ip1) * (*ip2));
 		next_cycle();
 	mul_r:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tMUL_R executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		rp1 = (r64*) sp;
 		rp2 = (r64*) (sp - wordsize);
@@ -821,10 +671,6 @@ execute_process(Process* pro)
 		*rp3 = ((*rp1) * (*rp2));
 		next_cycle();
 	div_b:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tDIV_B executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		bp1 = sp;
 		bp2 = (sp - wordsize);
@@ -832,10 +678,6 @@ execute_process(Process* pro)
 		*sp = ((*bp1) / (*bp2));
 		next_cycle();
 	div_u:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tDIV_U executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) sp;
 		up2 = (u64*) (sp - wordsize);
@@ -844,10 +686,6 @@ execute_process(Process* pro)
 		*up3 = ((*up1) / (*up2));
 		next_cycle();
 	div_i:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tDIV_I executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		ip1 = (s64*) sp;
 		ip2 = (s64*) (sp - wordsize);
@@ -856,10 +694,6 @@ execute_process(Process* pro)
 		*ip3 = ((*ip1) / (*ip2));
 		next_cycle();
 	div_r:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tDIV_R executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		rp1 = (r64*) sp;
 		rp2 = (r64*) (sp - wordsize);
@@ -868,10 +702,6 @@ execute_process(Process* pro)
 		*rp3 = ((*rp1) / (*rp2));
 		next_cycle();
 	mod_b:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tMOD_B executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		bp1 = sp;
 		bp2 = (sp - wordsize);
@@ -879,10 +709,6 @@ execute_process(Process* pro)
 		*sp = ((*bp1) % (*bp2));
 		next_cycle();
 	mod_u:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tMOD_U executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) sp;
 		up2 = (u64*) (sp - wordsize);
@@ -891,10 +717,6 @@ execute_process(Process* pro)
 		*up3 = ((*up1) % (*up2));
 		next_cycle();
 	mod_i:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tMOD_I executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		ip1 = (s64*) sp;
 		ip2 = (s64*) (sp - wordsize);
@@ -903,10 +725,6 @@ execute_process(Process* pro)
 		*ip3 = ((*ip1) % (*ip2));
 		next_cycle();
 	b2u:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tB2U executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) dbuf;
 		*up1 = (u64) (*sp);
@@ -914,10 +732,6 @@ execute_process(Process* pro)
 		*up2 = *up1;
 		next_cycle();
 	b2i:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tB2I executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		ip1 = (s64*) dbuf;
 		*ip1 = (s64) (*sp);
@@ -925,10 +739,6 @@ execute_process(Process* pro)
 		*ip2 = *ip1;
 		next_cycle();
 	b2r:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tB2R executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;/*
 		rp1 = (r64*) dbuf;
 		*rp1 = (r64) (*sp);
@@ -936,19 +746,11 @@ execute_process(Process* pro)
 		*rp2 = *rp1;*/ // fix all commented bullshit here.
 		next_cycle();
 	u2b:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tU2B executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) sp;
 		*sp = (u8) (*up1);
 		next_cycle();
 	u2i:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tU2I executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) sp;
 		ip1 = (s64*) dbuf;
@@ -957,10 +759,6 @@ execute_process(Process* pro)
 		*ip2 = *ip1;
 		next_cycle();
 	u2r:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tU2R executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) sp;
 		rp1 = (r64*) dbuf;
@@ -969,19 +767,11 @@ execute_process(Process* pro)
 		*rp2 = *rp1;
 		next_cycle();
 	i2b:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tI2B executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		ip1 = (s64*) sp;
 		*sp = (u8) (*ip1);
 		next_cycle();
 	i2u:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tI2U executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		ip1 = (s64*) sp;
 		up1 = (u64*) dbuf;
@@ -990,10 +780,6 @@ execute_process(Process* pro)
 		*up2 = *up1;
 		next_cycle();
 	i2r:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tI2R executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		ip1 = (s64*) sp;
 		rp1 = (r64*) dbuf;
@@ -1002,19 +788,11 @@ execute_process(Process* pro)
 		*rp2 = *rp1;
 		next_cycle();
 	r2b:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tR2B executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		rp1 = (r64*) sp;
 		*sp = (u8) (*rp1);
 		next_cycle();
 	r2u:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tR2U executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		rp1 = (r64*) sp;
 		up1 = (u64*) dbuf;
@@ -1023,10 +801,6 @@ execute_process(Process* pro)
 		*up2 = *up1;
 		next_cycle();
 	r2i:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tR2I executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		rp1 = (r64*) sp;
 		ip1 = (s64*) dbuf;
@@ -1035,10 +809,6 @@ execute_process(Process* pro)
 		*ip2 = *ip1;
 		next_cycle();
 	lstart:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tLSTART executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		lp_count = (*up1);
@@ -1051,36 +821,48 @@ execute_process(Process* pro)
 		ip = lp_cont;
 		next_cycle();
 	ltest:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tLTEST executed on cycle %u", (unsigned) cycnum);
-		#endif
 		if (lp_count) {
 			--lp_count;
 			ip = lp_cont;
 		} else {
 			ip = lp_stop;
+			if (vm->slice)
+				goto halt;
 		}
 		next_cycle();
 	lcont:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tLCONT executed on cycle %u", (unsigned) cycnum);
-		#endif
 		ip = lp_cont;
 		next_cycle();
 	lstop:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tLSTOP executed on cycle %u", (unsigned) cycnum);
-		#endif
+		ip = lp_stop;
+		if (vm->slice)
+			goto halt;
+		next_cycle();
+	plstart:
+		++ip;
+		up1 = (u64*) ip;
+		lp_count = (*up1);
+		ip += wordsize;
+		up1 = (u64*) ip;
+		lp_cont = img_byte(*up1);
+		ip += wordsize;
+		up1 = (u64*) ip;
+		lp_stop = img_byte(*up1);
+		ip += wordsize;
+		ip1 = (s64*) ip; // tdx stride per iteration.
+		ip += wordsize;
+		up1 = (u64*) ip; // accumulator address.
+		ip += wordsize;
+		up2 = (u64*) ip; // accumulator type.
+		if (!run_ploop(vm, tdx, lp_cont, lp_stop, lp_count, *ip1, (u64*) img_byte(*up1), *up2)) {
+			retval = VM_ERROR;
+			goto halt;
+		}
+		tdx += (s64) (lp_count + 1) * (*ip1);
+		lp_count = 0;
 		ip = lp_stop;
 		next_cycle();
 	put_b:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tPUT_B executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1089,10 +871,6 @@ execute_process(Process* pro)
 		++ip;
 		next_cycle();
 	put_nb:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tPUT_NB executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1103,10 +881,6 @@ execute_process(Process* pro)
 		ip += (*up1);
 		next_cycle();
 	put_hw:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tPUT_HW executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1115,10 +889,6 @@ execute_process(Process* pro)
 		ip += hwordsize;
 		next_cycle();
 	put_w:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tPUT_W executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1127,10 +897,6 @@ execute_process(Process* pro)
 		ip += wordsize;
 		next_cycle();
 	put_nw:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tPUT_NW executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1141,10 +907,6 @@ execute_process(Process* pro)
 		ip += (wordsize * (*up1));
 		next_cycle();
 	put_dw:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tPUT_DW executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1153,10 +915,6 @@ execute_process(Process* pro)
 		ip += dwordsize;
 		next_cycle();
 	put_qw:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tPUT_QW executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1165,10 +923,6 @@ execute_process(Process* pro)
 		ip += qwordsize;
 		next_cycle();
 	put_s:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tPUT_S executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1178,10 +932,6 @@ execute_process(Process* pro)
 		ip += c;
 		next_cycle();
 	cpy_b:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tCPY_B executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1192,10 +942,6 @@ execute_process(Process* pro)
 		*bp1 = *bp2;
 		next_cycle();
 	cpy_nb:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tCPY_NB executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1208,10 +954,6 @@ execute_process(Process* pro)
 		memcpy(bp1, bp2, (*up1));
 		next_cycle();
 	cpy_hw:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tCPY_HW executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1222,10 +964,6 @@ execute_process(Process* pro)
 		memcpy(bp1, bp2, hwordsize);
 		next_cycle();
 	cpy_w:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tCPY_W executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1236,10 +974,6 @@ execute_process(Process* pro)
 		memcpy(bp1, bp2, wordsize);
 		next_cycle();
 	cpy_nw:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tCPY_NW executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1252,10 +986,6 @@ execute_process(Process* pro)
 		memcpy(bp1, ip, (wordsize * (*up1)));
 		next_cycle();
 	cpy_dw:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tCPY_DW executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1266,10 +996,6 @@ execute_process(Process* pro)
 		memcpy(bp1, bp2, dwordsize);
 		next_cycle();
 	cpy_qw:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tCPY_QW executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1280,10 +1006,6 @@ execute_process(Process* pro)
 		memcpy(bp1, bp2, qwordsize);
 		next_cycle();
 	cpy_s:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tCPY_S executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1294,10 +1016,6 @@ execute_process(Process* pro)
 		strcpy(bp1, bp2);
 		next_cycle();
 	xch_b:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tXCH_B executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1311,10 +1029,6 @@ execute_process(Process* pro)
 		*bp2 = *bp3;
 		next_cycle();
 	xch_nb:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tXCH_NB executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1330,10 +1044,6 @@ execute_process(Process* pro)
 		memcpy(bp2, bp3, (*up1));
 		next_cycle();
 	xch_hw:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tXCH_HW executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1347,10 +1057,6 @@ execute_process(Process* pro)
 		memcpy(bp2, bp3, hwordsize);
 		next_cycle();
 	xch_w:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tXCH_W executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1364,10 +1070,6 @@ execute_process(Process* pro)
 		memcpy(bp2, bp3, wordsize);
 		next_cycle();
 	xch_nw:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tXCH_NW executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1383,10 +1085,6 @@ execute_process(Process* pro)
 		memcpy(bp2, bp3, (wordsize * (*up1)));
 		next_cycle();
 	xch_qw:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tXCH_QW executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1400,10 +1098,6 @@ execute_process(Process* pro)
 		memcpy(bp2, bp3, qwordsize);
 		next_cycle();
 	xch_dw:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tXCH_DW executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1417,10 +1111,6 @@ execute_process(Process* pro)
 		memcpy(bp2, bp3, dwordsize);
 		next_cycle();
 	xch_s:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tXCH_S executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1434,127 +1124,176 @@ execute_process(Process* pro)
 		strcpy(bp2, bp3);
 		next_cycle();
 	rstk_up:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nrstk_up executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		++rp;
+		note_depth();
 		next_cycle();		
 	rstk_dwn:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nrstk_dwn executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		--rp;
 		next_cycle();		
 	rstk_rst:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nrstk_rst executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		rp = rstk;
 		next_cycle();
 	openf:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\t OPENF executed on cycle %u", (unsigned) cycnum);
-		#endif
-		return retval;
-	rsv_sys2:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nrsv_io2 executed on cycle %u", (unsigned) cycnum);
-		#endif
-		return retval;
-	rsv_sys3:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nrsv_io3 executed on cycle %u", (unsigned) cycnum);
-		#endif
-		return retval;
-	rsv_sys4:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nrsv_io4 executed on cycle %u", (unsigned) cycnum);
-		#endif
-		return retval;
-	rsv_sys5:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nrsv_io5 executed on cycle %u", (unsigned) cycnum);
-		#endif
-		return retval;
-	rsv_sys6:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nrsv_io6 executed on cycle %u", (unsigned) cycnum);
-		#endif
-		return retval;
-	rsv_sys7:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nrsv_io7 executed on cycle %u", (unsigned) cycnum);
-		#endif
-		return retval;
-	rsv_sys8:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nrsv_io8 executed on cycle %u", (unsigned) cycnum);
-		#endif
-		return retval;
-	rsv_sys9:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nrsv_io9 executed on cycle %u", (unsigned) cycnum);
-		#endif
-		return retval;
-	rsv_sys10:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nrsv_io10 executed on cycle %u", (unsigned) cycnum);
-		#endif
-		return retval;
-	rsv_sys11:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nrsv_io6 executed on cycle %u", (unsigned) cycnum);
-		#endif
-		return retval;
-	rsv_sys12:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nrsv_io7 executed on cycle %u", (unsigned) cycnum);
-		#endif
-		return retval;
-	rsv_sys13:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nrsv_io8 executed on cycle %u", (unsigned) cycnum);
-		#endif
-		return retval;
-	rsv_sys14:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nrsv_io9 executed on cycle %u", (unsigned) cycnum);
-		#endif
-		return retval;
+		++ip;
+		up1 = (u64*) ip; // address of the fd word.
+		ip += wordsize;
+		up2 = (u64*) ip; // address of the path.
+		ip += wordsize;
+		up3 = (u64*) ip; // fopen mode code.
+		ip += wordsize;
+		ip1 = (s64*) img_byte(*up1);
+		*ip1 = file_open(pro->files, (const char*) img_byte(*up2), *up3);
+		next_cycle();
+	ncall:
+		++ip;
+		up1 = (u64*) ip; // native table index.
+		ip += wordsize;
+		up2 = (u64*) ip; // args in the window.
+		ip += wordsize;
+		up3 = (u64*) ip; // results written back.
+		ip += wordsize;
+		if ((*up1) >= NATIVE_TABLE_SIZE || !vm->natives[*up1].func) {
+			retval = VM_ERROR;
+			goto halt;
+		}
+		bp1 = sp + wordsize - ((*up2) * wordsize);
+		vm->natives[*up1].func((u64*) bp1, pro->img, vm->natives[*up1].data);
+		sp = bp1 - wordsize + ((*up3) * wordsize);
+		next_cycle();
+	closef:
+		++ip;
+		up1 = (u64*) ip;
+		ip += wordsize;
+		ip1 = (s64*) img_byte(*up1);
+		file_close(pro->files, *ip1);
+		*ip1 = -1;
+		next_cycle();
+	readf:
+		++ip;
+		up1 = (u64*) ip;
+		ip += wordsize;
+		ip1 = (s64*) img_byte(*up1);
+		sp += wordsize;
+		ip2 = (s64*) sp;
+		*ip2 = file_getc(pro->files, *ip1);
+		next_cycle();
+	writef:
+		++ip;
+		up1 = (u64*) ip;
+		ip += wordsize;
+		ip1 = (s64*) img_byte(*up1);
+		file_putc(pro->files, *ip1, *sp);
+		sp -= wordsize;
+		next_cycle();
+	seekf:
+		++ip;
+		up1 = (u64*) ip;
+		ip += wordsize;
+		up2 = (u64*) ip; // whence.
+		ip += wordsize;
+		ip1 = (s64*) img_byte(*up1);
+		ip2 = (s64*) sp; // offset, replaced with the new position.
+		*ip2 = file_seek(pro->files, *ip1, *ip2, *up2);
+		next_cycle();
+	readh:
+		++ip;
+		up1 = (u64*) ip;
+		ip += wordsize;
+		up2 = (u64*) ip; // destination address.
+		ip += wordsize;
+		ip1 = (s64*) img_byte(*up1);
+		ip2 = (s64*) sp; // count, replaced with the bytes read.
+		*ip2 = file_read(pro->files, *ip1, img_byte(*up2), (u64) *ip2);
+		next_cycle();
+	writeh:
+		++ip;
+		up1 = (u64*) ip;
+		ip += wordsize;
+		up2 = (u64*) ip; // source address.
+		ip += wordsize;
+		ip1 = (s64*) img_byte(*up1);
+		ip2 = (s64*) sp; // count, replaced with the bytes written.
+		*ip2 = file_write(pro->files, *ip1, img_byte(*up2), (u64) *ip2);
+		next_cycle();
+	areadh:
+		++ip;
+		up1 = (u64*) ip;
+		ip += wordsize;
+		up2 = (u64*) ip; // destination address.
+		ip += wordsize;
+		ip1 = (s64*) img_byte(*up1);
+		up3 = (u64*) sp; // count.
+		sp -= wordsize;
+		ip2 = (s64*) sp; // file offset, replaced with the ticket.
+		*ip2 = async_start(vm, AIO_READ, *ip1, img_byte(*up2), *up3, *ip2);
+		next_cycle();
+	awriteh:
+		++ip;
+		up1 = (u64*) ip;
+		ip += wordsize;
+		up2 = (u64*) ip; // source address.
+		ip += wordsize;
+		ip1 = (s64*) img_byte(*up1);
+		up3 = (u64*) sp; // count.
+		sp -= wordsize;
+		ip2 = (s64*) sp; // file offset, replaced with the ticket.
+		*ip2 = async_start(vm, AIO_WRITE, *ip1, img_byte(*up2), *up3, *ip2);
+		next_cycle();
+	await:
+		ip1 = (s64*) sp; // ticket, replaced with the result.
+		if ((u64) (*ip1) >= AIO_SLOTS || vm->aio[*ip1].state == AIO_FREE) {
+			*ip1 = -1;
+			++ip;
+			next_cycle();
+		}
+		if (vm->aio[*ip1].state == AIO_PENDING)
+			async_reap(vm->ring);
+		while (vm->aio[*ip1].state == AIO_PENDING) {
+			// Park with ip still on the AWAIT, it's retried when next run.
+			if (vm->parkable) {
+				retval = VM_PARKED;
+				goto halt;
+			}
+			if (async_wait(vm->ring) < 0)
+				async_fail(vm);
+		}
+		vm->aio[*ip1].state = AIO_FREE;
+		*ip1 = vm->aio[*ip1].result;
+		++ip;
+		next_cycle();
+	mapf:
+		++ip;
+		up1 = (u64*) ip; // address of the offset word, the size word follows.
+		ip += wordsize;
+		up2 = (u64*) ip; // address of the path.
+		ip += wordsize;
+		up3 = (u64*) ip; // advice code.
+		ip += wordsize;
+		ip1 = (s64*) img_byte(*up1);
+		*ip1 = file_map(pro, (const char*) img_byte(*up2), *up3, (u64*) (ip1 + 1));
+		next_cycle();
+	unmapf:
+		++ip;
+		up1 = (u64*) ip;
+		ip += wordsize;
+		ip1 = (s64*) img_byte(*up1);
+		file_unmap(pro, *ip1);
+		*ip1 = -1;
+		next_cycle();
+	flush:
+		out_flush(&vm->out);
+		flush_files(pro->files);
+		++ip;
+		next_cycle();
 	stk_tt_dup:
 		// REDUNDANT INSTRUCTION REMOVAL PERMENENTLY!
-		return retval;
+		goto halt;
 	rsv_sys15:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nrsv_io10 executed on cycle %u", (unsigned) cycnum);
-		#endif
-		return retval;
+		goto halt;
 	put_b_fs:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tPUT_B_FS executed on cycle %u", (unsigned) cycnum);
-		#endif
 		up1 = (u64*) sp;
 		bp1 = img_byte(*up1);
 		++ip;
@@ -1562,10 +1301,6 @@ execute_process(Process* pro)
 		++ip;
 		next_cycle();
 	put_w_fs:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tPUT_W_FS executed on cycle %u", (unsigned) cycnum);
-		#endif
 		up1 = (u64*) sp;
 		bp1 = img_byte(*up1);
 		++ip;
@@ -1573,10 +1308,6 @@ execute_process(Process* pro)
 		ip += wordsize;
 		next_cycle();
 	cpy_b_fs:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tCPY_B_FS executed on cycle %u", (unsigned) cycnum);
-		#endif
 		up1 = (u64*) sp;
 		bp1 = img_byte(*up1);
 		++ip;
@@ -1586,10 +1317,6 @@ execute_process(Process* pro)
 		*bp1 = *bp2;
 		next_cycle();
 	cpy_w_fs:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tCPY_W_FS executed on cycle %u", (unsigned) cycnum);
-		#endif
 		up1 = (u64*) sp;
 		bp1 = img_byte(*up1);
 		++ip;
@@ -1599,10 +1326,6 @@ execute_process(Process* pro)
 		memcpy(bp1, bp2, wordsize);
 		next_cycle();
 	xch_b_fs:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tXCH_B_FS executed on cycle %u", (unsigned) cycnum);
-		#endif
 		up1 = (u64*) sp;
 		bp1 = img_byte(*up1);
 		++ip;
@@ -1615,10 +1338,6 @@ execute_process(Process* pro)
 		*bp1 = *bp3;
 		next_cycle();
 	xch_w_fs:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tXCH_W_FS executed on cycle %u", (unsigned) cycnum);
-		#endif
 		up1 = (u64*) sp;
 		bp1 = img_byte(*up1);
 		++ip;
@@ -1631,20 +1350,12 @@ execute_process(Process* pro)
 		memcpy(bp1, bp3, wordsize);
 		next_cycle();
 	set_tdx_fc:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSET_TDX_FC executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		tdx = img_byte(*up1);
 		ip += wordsize;
 		next_cycle();
 	set_tdx_fh:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSET_TDX_FH executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		up1 = (u64*) img_byte(*up1);
@@ -1652,91 +1363,51 @@ execute_process(Process* pro)
 		tdx = img_byte(*up1);
 		next_cycle();
 	set_tdx_fs:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSET_TDX_FH executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) sp;
 		tdx = img_byte(*up1);
 		next_cycle();
 	tdx_b_up:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tTDX_B_UP executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++tdx;
 		++ip;
 		next_cycle();	
 	tdx_b_dwn:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tTDX_B_DWN executed on cycle %u", (unsigned) cycnum);
-		#endif
 		--tdx;
 		++ip;
 		next_cycle();	
 	tdx_w_up:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tTDX_W_UP executed on cycle %u", (unsigned) cycnum);
-		#endif
 		tdx += wordsize;
 		++ip;
 		next_cycle();
 	tdx_w_dwn:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tTDX_W_DWN executed on cycle %u", (unsigned) cycnum);
-		#endif
 		tdx -= wordsize;
 		++ip;
 		next_cycle();
 	t_fd_putb:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nT_FD_PUTB executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		*tdx = *ip;
 		++tdx;
 		++ip;
 		next_cycle();
 	t_bk_putb:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nT_BK_PUTB executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		*tdx = *ip;
 		--tdx;
 		++ip;
 		next_cycle();
 	t_fd_putw:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nT_FD_PUTW executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		memcpy(tdx, ip, wordsize);
 		tdx += wordsize;
 		ip += wordsize;
 		next_cycle();
 	t_bk_putw:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nT_BK_PUTW executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		memcpy(tdx, ip, wordsize);
 		tdx -= wordsize;
 		ip += wordsize;
 		next_cycle();
 	t_fd_cpyb:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nT_FD_CPYB executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1745,10 +1416,6 @@ execute_process(Process* pro)
 		++tdx;
 		next_cycle();
 	t_bk_cpyb:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nT_BK_CPYB executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1757,10 +1424,6 @@ execute_process(Process* pro)
 		--tdx;
 		next_cycle();
 	t_fd_cpyw:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nT_FD_CPYW executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1769,10 +1432,6 @@ execute_process(Process* pro)
 		++tdx;
 		next_cycle();
 	t_bk_cpyw:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nT_BK_CPYW executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1781,100 +1440,60 @@ execute_process(Process* pro)
 		++tdx;
 		next_cycle();
 	t_fd_popb:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nT_FD_POPB executed on cycle %u", (unsigned) cycnum);
-		#endif
 		*sp = *tdx;
 		sp -= wordsize;
 		++tdx;
 		++ip;
 		next_cycle();
 	t_bk_popb:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nT_BK_POPB executed on cycle %u", (unsigned) cycnum);
-		#endif
 		*sp = *tdx;
 		sp -= wordsize;
 		--tdx;
 		++ip;
 		next_cycle();
 	t_fd_popw:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nT_FD_POPW executed on cycle %u", (unsigned) cycnum);
-		#endif
 		memcpy(tdx, sp, wordsize);
 		sp -= wordsize;
 		++tdx;
 		++ip;
 		next_cycle();
 	t_bk_popw:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nT_BK_POPW executed on cycle %u", (unsigned) cycnum);
-		#endif
 		memcpy(tdx, sp, wordsize);
 		sp -= wordsize;
 		--tdx;
 		++ip;
 		next_cycle();
 	t_fd_pshb:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nT_FD_PSHB executed on cycle %u", (unsigned) cycnum);
-		#endif
 		sp += wordsize;
 		*sp = *tdx;
 		++tdx;
 		++ip;
 		next_cycle();
 	t_bk_pshb:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nT_BK_PSHB executed on cycle %u", (unsigned) cycnum);
-		#endif
 		sp += wordsize;
 		*sp = *tdx;
 		--tdx;
 		++ip;
 		next_cycle();
 	t_fd_pshw:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nT_FD_PSHW executed on cycle %u", (unsigned) cycnum);
-		#endif
 		sp += wordsize;
 		memcpy(sp, tdx, wordsize);
 		tdx += wordsize;
 		ip += wordsize;
 		next_cycle();
 	t_bk_pshw:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nT_BK_PSHW executed on cycle %u", (unsigned) cycnum);
-		#endif
 		sp += wordsize;
 		memcpy(sp, tdx, wordsize);
 		tdx -= wordsize;
 		ip += wordsize;
 		next_cycle();
 	stk_spoffs:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nSTK_SPOFFS executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		sp += wordsize;
 		up1 = (u64*) sp;
 		*up1 = sp_offset();
 		next_cycle();	
 	stk_save:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nSTK_SAVE executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1882,10 +1501,6 @@ execute_process(Process* pro)
 		ip += wordsize;
 		next_cycle();
 	stk_load:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nSTK_LOAD executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -1893,43 +1508,23 @@ execute_process(Process* pro)
 		ip += wordsize;
 		next_cycle();
 	stk_up:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nSTK_UP executed on cycle %u", (unsigned) cycnum);
-		#endif
 		sp += wordsize;
 		++ip;
 		next_cycle();
 	stk_dwn:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nSTK_DOWN executed on cycle %u", (unsigned) cycnum);
-		#endif
 		sp -= wordsize;
 		++ip;
 		next_cycle();
 	stk_rst:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nSTK_DOWN executed on cycle %u", (unsigned) cycnum);
-		#endif
 		sp = stk;
 		++ip;
 		next_cycle();
 	stk_clr:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nSTK_DOWN executed on cycle %u", (unsigned) cycnum);
-		#endif
 		memset(stk, 0, STACK_SIZE);
 		sp = stk;
 		++ip;
 		next_cycle();
 	stk_set:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSTK_SET executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = sp - (*up1);
@@ -1940,10 +1535,6 @@ execute_process(Process* pro)
 		ip += wordsize;
 		next_cycle();
 	stk_setn:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nSTK_SETN executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = sp - (*up1);
@@ -1956,10 +1547,6 @@ execute_process(Process* pro)
 		ip += wordsize;
 		next_cycle();
 	stk_setc:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSTK_SETC executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = sp - (*up1);
@@ -1968,10 +1555,6 @@ execute_process(Process* pro)
 		ip += wordsize;
 		next_cycle();
 	stk_setcn:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSTK_SETCN executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = sp - (*up1);
@@ -1984,10 +1567,6 @@ execute_process(Process* pro)
 		ip += wordsize;
 		next_cycle();
 	stk_cpy:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nSTK_CPY executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = (sp - (*up1));
@@ -1998,10 +1577,6 @@ execute_process(Process* pro)
 		ip += wordsize;
 		next_cycle();
 	stk_cpyn:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nSTK_CPYN executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = (sp - (*up1));
@@ -2014,10 +1589,6 @@ execute_process(Process* pro)
 		ip += wordsize;
 		next_cycle();
 	stk_xch:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nSTK_XCH executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = (sp - (*up1));
@@ -2031,10 +1602,6 @@ execute_process(Process* pro)
 		memcpy(bp1, bp3, wordsize);
 		next_cycle();
 	stk_xchn:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nSTK_XCHN executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = (sp - (*up1));
@@ -2050,10 +1617,6 @@ execute_process(Process* pro)
 		memcpy(bp1, bp3, (*up1));
 		next_cycle();
 	stk_hxch:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nSTK_HXCH executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -2067,10 +1630,6 @@ execute_process(Process* pro)
 		memcpy(bp1, bp3, wordsize);
 		next_cycle();
 	stk_hxchn:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nSTK_HXCHN executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -2086,42 +1645,34 @@ execute_process(Process* pro)
 		memcpy(bp1, bp3, (*up1));
 		next_cycle();
 	stk_mov:
-		return retval;
+		goto halt;
 	stk_movn:
-		return retval;
+		goto halt;
 	stk_del:
-		return retval;
+		goto halt;
 	stk_deln:
-		return retval;
+		goto halt;
 	stk_get:
-		return retval;
+		goto halt;
 	stk_getn:
-		return retval;
+		goto halt;
 	stk_ins:
-		return retval;
+		goto halt;
 	stk_insn:
-		return retval;
+		goto halt;
 	stk_2top:
-		return retval;
+		goto halt;
 	stk_xt_dup:
-		return retval;
+		goto halt;
 	stk_tx_dup:
-		return retval;
+		goto halt;
 	stk_top_dup:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nSTK_TOP_DUP executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		bp1 = sp;
 		sp += wordsize;
 		memcpy(sp, bp1, wordsize);
 		next_cycle();
 	stk_top_dup2:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSTK_TOP_DUP executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		bp1 = sp;
 		sp += wordsize;
@@ -2130,22 +1681,14 @@ execute_process(Process* pro)
 		memcpy(sp, bp1, wordsize);
 		next_cycle();
 	stk_dup:
-		return retval;
+		goto halt;
 	stk_tapsh:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSTK_TAPSH executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) sp;
 		bp1 = img_byte(*up1);
 		memcpy(sp, bp1, wordsize);
 		next_cycle();
 	stk_psh:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSTK_PSH executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -2154,50 +1697,30 @@ execute_process(Process* pro)
 		ip += wordsize;
 		next_cycle();
 	stk_pshc:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSTK_PSHC executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		sp += wordsize;
 		memcpy(sp, ip, wordsize);
 		ip += wordsize;
 		next_cycle();
 	stk_psh0:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSTK_PSH0 executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		sp += wordsize;
 		up1 = (u64*) sp;
 		*up1 = 0;
 		next_cycle();
 	stk_psh1:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSTK_PSH1 executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		sp += wordsize;
 		up1 = (u64*) sp;
 		*up1 = 1;
 		next_cycle();
 	stk_psh2:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSTK_PSH2 executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		sp += wordsize;
 		up1 = (u64*) sp;
 		*up1 = 2;
 		next_cycle();
 	stk_ovwr:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSTK_OVWR executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -2205,46 +1728,26 @@ execute_process(Process* pro)
 		ip += wordsize;
 		next_cycle();
 	stk_ovwrc:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSTK_OVWRC executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		memcpy(sp, ip, wordsize);
 		ip += wordsize;
 		next_cycle();
 	stk_ovwr0:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSTK_OVWR0 executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) sp;
 		*up1 = 0;
 		next_cycle();
 	stk_ovwr1:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSTK_OVWR1 executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) sp;
 		*up1 = 1;
 		next_cycle();
 	stk_ovwr2:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSTK_OVWR2 executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) sp;
 		*up1 = 2;
 		next_cycle();
 	stk_stor:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSTR_STOR executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -2252,10 +1755,6 @@ execute_process(Process* pro)
 		ip += wordsize;
 		next_cycle();
 	stk_pop:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSTR_POP executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -2264,10 +1763,6 @@ execute_process(Process* pro)
 		ip += wordsize;
 		next_cycle();
 	stk_xcht:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSTR_XCHT executed on cycle %u", (unsigned) cycnum);
-		#endif
 		bp1 = dbuf;
 		bp2 = sp;
 		bp3 = (sp - wordsize);
@@ -2277,10 +1772,6 @@ execute_process(Process* pro)
 		++ip;
 		next_cycle();
 	stk_gcol:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSTR_GCOL executed on cycle %u", (unsigned) cycnum);
-		#endif
 		c = ((u64) (sp - stk));
 		if (c > GCOL_THRESHOLD) {
 			;
@@ -2288,10 +1779,6 @@ execute_process(Process* pro)
 		++ip;
 		next_cycle();
 	str_cat:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nSTR_CAT executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -2302,10 +1789,6 @@ execute_process(Process* pro)
 		strcat(bp1, bp2);
 		next_cycle();
 	str_ncat:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nSTR_NCAT executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -2318,10 +1801,6 @@ execute_process(Process* pro)
 		strncat(bp1, bp2, (*up1));
 		next_cycle();
 	str_len:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nSTR_LEN executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -2331,10 +1810,6 @@ execute_process(Process* pro)
 		ip += wordsize;
 		next_cycle();
 	str_cmp:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nSTR_CMP executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -2347,10 +1822,6 @@ execute_process(Process* pro)
 		*up1 = strcmp(bp1, bp2);
 		next_cycle();
 	str_ncmp:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\nSTR_CMP executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -2365,16 +1836,39 @@ execute_process(Process* pro)
 		*up1 = strncmp(bp1, bp2, (*up1));
 		next_cycle();
 	str_str:
-		return retval;
+		++ip;
+		up1 = (u64*) ip;
+		bp1 = img_byte(*up1);
+		ip += wordsize;
+		up1 = (u64*) ip;
+		ip += wordsize;
+		sp += wordsize;
+		ip1 = (s64*) sp;
+		*ip1 = str_kernels()->str(bp1, img_byte(*up1));
+		next_cycle();
 	str_cspn:
-		return retval;
+		++ip;
+		up1 = (u64*) ip;
+		bp1 = img_byte(*up1);
+		ip += wordsize;
+		up1 = (u64*) ip;
+		ip += wordsize;
+		sp += wordsize;
+		ip1 = (s64*) sp;
+		*ip1 = str_kernels()->cspn(bp1, img_byte(*up1));
+		next_cycle();
 	str_chr:
-		return retval;
+		++ip;
+		up1 = (u64*) ip;
+		bp1 = img_byte(*up1);
+		ip += wordsize;
+		up1 = (u64*) ip;
+		ip += wordsize;
+		sp += wordsize;
+		ip1 = (s64*) sp;
+		*ip1 = str_kernels()->chr(bp1, (u8) *up1);
+		next_cycle();
 	jmp_str_cmp:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tJMP_STR_CMP executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -2392,10 +1886,6 @@ execute_process(Process* pro)
 		}
 		next_cycle();
 	jmp_str_ncmp:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tJMP_STR_NCMP executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
@@ -2414,125 +1904,430 @@ execute_process(Process* pro)
 			ip += wordsize;
 		}
 		next_cycle();
+	ls_new:
+		++ip;
+		up1 = (u64*) ip; // descriptor address.
+		ip += wordsize;
+		up2 = (u64*) ip; // capacity.
+		ip += wordsize;
+		if (ls_new(pro, (LStr*) img_byte(*up1), *up2) < 0) {
+			retval = VM_ERROR;
+			goto halt;
+		}
+		next_cycle();
+	ls_from:
+		++ip;
+		up1 = (u64*) ip;
+		ip += wordsize;
+		up2 = (u64*) ip; // NUL-terminated source.
+		ip += wordsize;
+		if (ls_from(pro, (LStr*) img_byte(*up1), img_byte(*up2)) < 0) {
+			retval = VM_ERROR;
+			goto halt;
+		}
+		next_cycle();
+	ls_toc:
+		++ip;
+		up1 = (u64*) ip; // NUL-terminated destination.
+		ip += wordsize;
+		up2 = (u64*) ip;
+		ip += wordsize;
+		ls_toc(pro, img_byte(*up1), (LStr*) img_byte(*up2));
+		next_cycle();
+	ls_len:
+		++ip;
+		up1 = (u64*) ip;
+		ip += wordsize;
+		sp += wordsize;
+		up2 = (u64*) sp;
+		*up2 = ((LStr*) img_byte(*up1))->len;
+		next_cycle();
+	ls_cat:
+		++ip;
+		up1 = (u64*) ip;
+		ip += wordsize;
+		up2 = (u64*) ip;
+		ip += wordsize;
+		if (ls_cat(pro, (LStr*) img_byte(*up1), (LStr*) img_byte(*up2)) < 0) {
+			retval = VM_ERROR;
+			goto halt;
+		}
+		next_cycle();
+	ls_cmp:
+		++ip;
+		up1 = (u64*) ip;
+		ip += wordsize;
+		up2 = (u64*) ip;
+		ip += wordsize;
+		sp += wordsize;
+		ip1 = (s64*) sp;
+		*ip1 = ls_cmp(pro, (LStr*) img_byte(*up1), (LStr*) img_byte(*up2));
+		next_cycle();
+	jmp_ls_eq:
+		++ip;
+		up1 = (u64*) ip;
+		ip += wordsize;
+		up2 = (u64*) ip;
+		ip += wordsize;
+		if (ls_eq(pro, (LStr*) img_byte(*up1), (LStr*) img_byte(*up2))) {
+			up1 = (u64*) ip;
+			ip = img_byte(*up1);
+		} else {
+			ip += wordsize;
+		}
+		next_cycle();
+	ls_sub:
+		++ip;
+		up1 = (u64*) ip; // view descriptor.
+		ip += wordsize;
+		up2 = (u64*) ip; // string viewed.
+		ip += wordsize;
+		up3 = (u64*) sp; // length.
+		sp -= wordsize;
+		wp1 = (w64*) sp; // start.
+		sp -= wordsize;
+		ls_sub((LStr*) img_byte(*up1), (LStr*) img_byte(*up2), *wp1, *up3);
+		next_cycle();
+	ls_free:
+		++ip;
+		up1 = (u64*) ip;
+		ip += wordsize;
+		ls_free(pro, (LStr*) img_byte(*up1));
+		next_cycle();
+	red_sum:
+		++ip;
+		up1 = (u64*) ip; // table.
+		ip += wordsize;
+		up2 = (u64*) ip; // element count.
+		ip += wordsize;
+		up3 = (u64*) ip; // type.
+		ip += wordsize;
+		sp += wordsize;
+		if (!reduce(REDUCE_SUM, (*up3), img_byte(*up1), NULL, (*up2), (u64*) sp)) {
+			sp -= wordsize;
+			retval = VM_ERROR;
+			goto halt;
+		}
+		next_cycle();
+	red_min:
+		++ip;
+		up1 = (u64*) ip; // table.
+		ip += wordsize;
+		up2 = (u64*) ip; // element count.
+		ip += wordsize;
+		up3 = (u64*) ip; // type.
+		ip += wordsize;
+		sp += wordsize;
+		if (!reduce(REDUCE_MIN, (*up3), img_byte(*up1), NULL, (*up2), (u64*) sp)) {
+			sp -= wordsize;
+			retval = VM_ERROR;
+			goto halt;
+		}
+		next_cycle();
+	red_max:
+		++ip;
+		up1 = (u64*) ip; // table.
+		ip += wordsize;
+		up2 = (u64*) ip; // element count.
+		ip += wordsize;
+		up3 = (u64*) ip; // type.
+		ip += wordsize;
+		sp += wordsize;
+		if (!reduce(REDUCE_MAX, (*up3), img_byte(*up1), NULL, (*up2), (u64*) sp)) {
+			sp -= wordsize;
+			retval = VM_ERROR;
+			goto halt;
+		}
+		next_cycle();
+	red_dot:
+		++ip;
+		up1 = (u64*) ip; // tables.
+		ip += wordsize;
+		up2 = (u64*) ip;
+		ip += wordsize;
+		up3 = (u64*) ip; // element count.
+		ip += wordsize;
+		c = *((u64*) ip); // type.
+		ip += wordsize;
+		sp += wordsize;
+		if (!reduce(REDUCE_DOT, c, img_byte(*up1), img_byte(*up2), (*up3), (u64*) sp)) {
+			sp -= wordsize;
+			retval = VM_ERROR;
+			goto halt;
+		}
+		next_cycle();
+	t_fd_cpynw:
+		++ip;
+		up1 = (u64*) ip; // source table.
+		ip += wordsize;
+		up2 = (u64*) sp; // word count.
+		sp -= wordsize;
+		bulk_copy(tdx, img_byte(*up1), (*up2));
+		tdx += (*up2) * wordsize;
+		next_cycle();
+	t_fd_fillnw:
+		++ip;
+		up1 = (u64*) ip; // fill value.
+		ip += wordsize;
+		up2 = (u64*) sp; // word count.
+		sp -= wordsize;
+		bulk_fill(tdx, (*up1), (*up2));
+		tdx += (*up2) * wordsize;
+		next_cycle();
+	t_cmpnw:
+		++ip;
+		up1 = (u64*) ip;
+		ip += wordsize;
+		bp1 = img_byte(*up1);
+		ip1 = (s64*) sp; // word count, replaced by the result.
+		c = bulk_diff(tdx, bp1, (*ip1));
+		if (c == (*ip1))
+			*ip1 = 0;
+		else
+			*ip1 = (((u64*) tdx)[c] < ((u64*) bp1)[c]) ? -1 : 1;
+		next_cycle();
+	t_diffnw:
+		++ip;
+		up1 = (u64*) ip;
+		ip += wordsize;
+		up2 = (u64*) sp; // word count, replaced by the result.
+		*up2 = bulk_diff(tdx, img_byte(*up1), (*up2));
+		next_cycle();
+	hmap_new:
+		++ip;
+		up1 = (u64*) ip; // descriptor address.
+		ip += wordsize;
+		up2 = (u64*) ip; // key kind.
+		ip += wordsize;
+		if (hmap_new(pro, (HMap*) img_byte(*up1), (*up2)) < 0) {
+			retval = VM_ERROR;
+			goto halt;
+		}
+		next_cycle();
+	hmap_put:
+		++ip;
+		up1 = (u64*) ip; // descriptor address.
+		ip += wordsize;
+		up2 = (u64*) (sp - wordsize); // key, then value on top.
+		up3 = (u64*) sp;
+		sp -= wordsize * 2;
+		if (hmap_put(pro, (HMap*) img_byte(*up1), (*up2), (*up3)) < 0) {
+			retval = VM_ERROR;
+			goto halt;
+		}
+		next_cycle();
+	hmap_get:
+		++ip;
+		up1 = (u64*) ip; // descriptor address.
+		ip += wordsize;
+		up2 = (u64*) sp; // key, replaced by the value then found pushed.
+		sp += wordsize;
+		up3 = (u64*) sp;
+		*up3 = hmap_get(pro, (HMap*) img_byte(*up1), (*up2), up2);
+		if (!(*up3))
+			*up2 = 0;
+		next_cycle();
+	hmap_del:
+		++ip;
+		up1 = (u64*) ip; // descriptor address.
+		ip += wordsize;
+		up2 = (u64*) sp; // key, replaced by whether it was there.
+		*up2 = hmap_del(pro, (HMap*) img_byte(*up1), (*up2));
+		next_cycle();
+	hmap_iter:
+		++ip;
+		up1 = (u64*) ip; // descriptor address.
+		ip += wordsize;
+		up2 = (u64*) sp; // cursor, replaced by key, value and next cursor.
+		sp += wordsize * 2;
+		up3 = (u64*) sp;
+		*up3 = hmap_next(pro, (HMap*) img_byte(*up1), (*up2), up2, (u64*) (sp - wordsize));
+		if (!(*up3)) {
+			*up2 = 0;
+			*((u64*) (sp - wordsize)) = 0;
+		}
+		next_cycle();
+	hmap_len:
+		++ip;
+		up1 = (u64*) ip; // descriptor address.
+		ip += wordsize;
+		sp += wordsize;
+		up2 = (u64*) sp;
+		*up2 = ((HMap*) img_byte(*up1))->len;
+		next_cycle();
+	hmap_free:
+		++ip;
+		up1 = (u64*) ip; // descriptor address.
+		ip += wordsize;
+		hmap_free(pro, (HMap*) img_byte(*up1));
+		next_cycle();
+	sort:
+		++ip;
+		up1 = (u64*) ip; // table.
+		ip += wordsize;
+		up2 = (u64*) ip; // element count.
+		ip += wordsize;
+		up3 = (u64*) ip; // key type.
+		ip += wordsize;
+		if (!sort_table(img_byte(*up1), (*up2), (*up3), FALSE)) {
+			retval = VM_ERROR;
+			goto halt;
+		}
+		next_cycle();
+	sort_kv:
+		++ip;
+		up1 = (u64*) ip; // table.
+		ip += wordsize;
+		up2 = (u64*) ip; // element count.
+		ip += wordsize;
+		up3 = (u64*) ip; // key type.
+		ip += wordsize;
+		if (!sort_table(img_byte(*up1), (*up2), (*up3), TRUE)) {
+			retval = VM_ERROR;
+			goto halt;
+		}
+		next_cycle();
+	prof_dump:
+		++ip;
+		if (vm->prof)
+			prof_dump(vm->prof, &vm->out);
+		next_cycle();
 	show_top_b:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSHOW_TOP_B executed on cycle %u", (unsigned) cycnum);
-		#endif
-		printf("\n\t\tstack-top(u8): %u", (unsigned) *sp);
+		out_str(&vm->out, "\n\t\tstack-top(u8): ");
+		out_u64(&vm->out, *sp);
 		++ip;
 		next_cycle();
 	show_top_u:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSHOW_TOP_U executed on cycle %u", (unsigned) cycnum);
-		#endif
 		up1 = (u64*) sp;
-		printf("\n\t\tstack-top(u64): %u", (unsigned) *up1);
+		out_str(&vm->out, "\n\t\tstack-top(u64): ");
+		out_u64(&vm->out, *up1);
 		++ip;
 		next_cycle();
 	show_top_i:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSHOW_TOP_I executed on cycle %u", (unsigned) cycnum);
-		#endif
 		ip1 = (s64*) sp;
-		printf("\n\t\tstack-top(s64): %d", (int) *ip1);
+		out_str(&vm->out, "\n\t\tstack-top(s64): ");
+		out_s64(&vm->out, *ip1);
 		++ip;
 		next_cycle();
 	show_top_r:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSHOW_TOP_R executed on cycle %u", (unsigned) cycnum);
-		#endif
 		rp1 = (r64*) sp;
-		printf("\n\t\tstack-top(s64): %f", (double) *rp1);
+		out_str(&vm->out, "\n\t\tstack-top(r64): ");
+		out_r64(&vm->out, *rp1);
 		++ip;
 		next_cycle();
 	show_mem_b:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSHOW_MEM_B executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = img_byte(*up1);
 		ip += wordsize;
-		printf("\n\t\theap[%u] = (u8) %u", (unsigned) *up1, (unsigned) *bp1);
+		out_str(&vm->out, "\n\t\theap[");
+		out_u64(&vm->out, *up1);
+		out_str(&vm->out, "] = (u8) ");
+		out_u64(&vm->out, *bp1);
 		next_cycle();
 	show_mem_u:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSHOW_MEM_U executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		up2 = (u64*) img_byte(*up1);
 		ip += wordsize;
-		printf("\n\t\theap[%u] = (u64) %u", (unsigned) *up1, (unsigned) *up2);
+		out_str(&vm->out, "\n\t\theap[");
+		out_u64(&vm->out, *up1);
+		out_str(&vm->out, "] = (u64) ");
+		out_u64(&vm->out, *up2);
 		next_cycle();
 	show_mem_i:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSHOW_MEM_I executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		ip1 = (s64*) img_byte(*up1);
 		ip += wordsize;
-		printf("\n\t\theap[%u] = (s64) %u", (unsigned) *up1, (int) *ip2);
+		out_str(&vm->out, "\n\t\theap[");
+		out_u64(&vm->out, *up1);
+		out_str(&vm->out, "] = (s64) ");
+		out_s64(&vm->out, *ip1);
 		next_cycle();
 	show_mem_r:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSHOW_MEM_R executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		rp1 = (r64*) img_byte(*up1);
 		ip += wordsize;
-		printf("\n\t\theap[%u] = (r64) %f", (unsigned) *up1, (double) *rp1);
+		out_str(&vm->out, "\n\t\theap[");
+		out_u64(&vm->out, *up1);
+		out_str(&vm->out, "] = (r64) ");
+		out_r64(&vm->out, *rp1);
 		next_cycle();
 	show_mem_s:
-		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tSHOW_MEM_S executed on cycle %u", (unsigned) cycnum);
-		#endif
 		++ip;
 		up1 = (u64*) ip;
 		bp1 = (char*) img_byte(*up1);
-		printf("\n\t\theap[%u] = (str) \"%s\"", (unsigned) *up1, (char*) bp1);
+		out_str(&vm->out, "\n\t\theap[");
+		out_u64(&vm->out, *up1);
+		out_str(&vm->out, "] = (str) \"");
+		out_str(&vm->out, (char*) bp1);
+		out_str(&vm->out, "\"");
 		ip += wordsize;
 		next_cycle();
 
 // Debugger Control.
 	breakpoint:
 		#ifdef DEBUG_MODE
-		++cycnum;
-		printf("\n\tBREAKPOINT executed on cycle %u", (unsigned) cycnum);
-		goto die;
+		db_op = db_break_op(pro, ip);
+		if (vm->slice || !pro->debug) {
+			if (db_op >= 0)
+				goto *optable[db_op];
+			goto die;
+		}
+		// A patched in one stops before the instruction it covers, an assembled one after itself.
+		if (db_op < 0)
+			++ip;
+		out_str(&vm->out, "\n\tbreakpoint");
+		goto db_start;
 		#else
 		goto nop;
 		#endif
 
 	#ifdef DEBUG_MODE
 	db_start:
+		db_disarm(pro);
+		out_flush(&vm->out);
+		dbprint_where(pro, ip);
 		goto *dbtable[dbmenu_input()];
 
 		dbact_stop:
 			goto db_start;
 		dbact_run:
-			db_mode = RUN;
-			next_cycle();
+			db_arm(pro, ip);
+			dispatch = run_table;
+			if (db_break_find(pro, ip) < 0)
+				next_op();
+			db_skip = ip;
+			dispatch = dbrearmtable;
+			goto *run_table[*ip];
+		db_rearm:
+			*db_skip = BREAKPOINT;
+			dispatch = run_table;
+			next_op();
 		dbact_step:
-			db_mode = STEP;
-			next_cycle();
+			++cycnum;
+			out_trace(&vm->out, opcode_strmap[*ip], cycnum);
+			dispatch = dbtraptable;
+			goto *run_table[*ip];
+		db_trap:
+			goto db_start;
+		dbact_break:
+			addr = (u64) dbread_addr(pro, "break");
+			if ((s64) addr >= 0 && db_break_set(pro, addr) < 0)
+				printf("\n\tno room for another breakpoint.");
+			goto db_start;
+		dbact_clear:
+			addr = (u64) dbread_addr(pro, "clear");
+			if ((s64) addr >= 0)
+				db_break_clear(pro, addr);
+			goto db_start;
 		dbact_end:
-			return retval;
+			goto halt;
 	    dbact_reset:
-	        db_mode = STEP;
 	        ip = pro->start_byte;
-		    cycnum = 1;
+		    cycnum = 0;
 		    sp = stk;
 		    goto db_start;
 		dbact_print_stk:
@@ -2622,103 +2417,615 @@ execute_process(Process* pro)
 		            printf("\n\t\theap[%u] = (r64) %f",  (unsigned) addr, (double) *rp1);
 		            break;
 		    }
+		    dbprint_symbol(pro, addr);
 		    goto db_start;
 		#endif
+
+// Context Control.
+	trap:
+		retval = VM_STEPPED;
+		goto halt;
+	samp:
+		note_depth();
+		// The tick landed in whatever ran last, a long instruction's time is its own.
+		if (vm->samp->pending)
+			sampler_record(vm->samp, pro, samp_ip, rstk, rp);
+		samp_ip = ip;
+		if (vm->trace)
+			goto trace;
+		if (vm->prof)
+			goto prof;
+		goto *optable[*ip];
+	trace:
+		note_depth();
+		trace_record(vm->trace, ip, sp);
+		if (vm->prof)
+			goto prof;
+		goto *optable[*ip];
+	prof:
+		note_depth();
+		prof_tick(vm->prof, *ip);
+		goto *optable[*ip];
+	depth:
+		note_depth();
+		goto *optable[*ip];
+	halt:
+		if (vm->prof)
+			prof_stop(vm->prof);
+		if (vm->samp)
+			sampler_disarm(vm->samp);
+		#ifdef DEBUG_MODE
+		if (!vm->slice)
+			db_disarm(pro);
+		#endif
+		// A stopped process can't be left with reads landing in its image.
+		if (vm->ring && retval != VM_STEPPED && retval != VM_PARKED)
+			async_drain(vm);
+		if (retval != VM_STEPPED && retval != VM_PARKED && !vm->slice)
+			out_flush(&vm->out);
+		// PLSTART workers' stacks are their own, only the owner's are counted.
+		note_depth();
+		if (!vm->slice) {
+			pro->usage.stk_peak  = (u64) (sp_peak - stk);
+			pro->usage.rstk_peak = (u64) (rp_peak - rstk);
+			if (mode != EXEC_STEP && run_table == optable)
+				pro->usage.approx = TRUE;
+		}
+		vm->ip = ip;
+		vm->sp = sp;
+		vm->rp = rp;
+		vm->tdx = tdx;
+		vm->lp_cont = lp_cont;
+		vm->lp_stop = lp_stop;
+		vm->lp_count = lp_count;
+		vm->c1 = c1;
+		vm->c2 = c2;
+		vm->c3 = c3;
+		vm->c4 = c4;
+		return retval;
 }
 
-Process*
-malloc_process()
+
+VMContext*
+new_context(Process* pro)
 {
-	void* mc = malloc(sizeof(Process));
-	Process* pro;
+	VMContext* vm = (VMContext*) malloc(sizeof(VMContext));
 
-	if (mc) {
-		pro = (Process*) mc;
-	} else {
+	if (!vm)
 		return 0;
-	}
 
-	pro->start_byte = 0;
-	pro->img = 0;
+	vm->owner = 0;
+	vm->slice = FALSE;
+	vm->ring = 0;
+	vm->own_ring = FALSE;
+	vm->parkable = FALSE;
+	memset(vm->aio, 0, sizeof(vm->aio));
+	out_init(&vm->out);
+	vm->prof = 0;
+	vm->samp = 0;
+	vm->trace = 0;
+	vm->depth = FALSE;
+	memset(vm->callret, DIE, wordsize);
+	load_builtin_natives(vm->natives);
+	if (pro)
+		bind_context(vm, pro);
+	else
+		vm->pro = 0;
 
-	return pro;
+	return vm;
 }
 
 
 void
-free_process(Process* pro)
+free_context(VMContext* vm)
 {
-	free(pro->img);
-	free(pro);
+	if (vm->ring) {
+		async_drain(vm);
+		if (vm->own_ring)
+			free_async_ring(vm->ring);
+	}
+	if (vm->owner)
+		free_process(vm->owner);
+	free_profile(vm->prof);
+	free_sampler(vm->samp);
+	free_tracer(vm->trace);
+	free(vm);
 }
 
 
-Process*
-build_process(const char* path, ProcessArgs* pargs)
+/*
+	Bind Context:
+		Points a context at a process and resets its registers ready to
+		run the process from its start byte with empty stacks.
+*/
+void
+bind_context(VMContext* vm, Process* pro)
 {
-	// Pointers used for writing metadata values.
-	u64 *up0, *up1, *up2, *up3, *up4;
-	u8* bp;
+	vm->pro = pro;
+	vm->ip  = pro->start_byte;
+	vm->sp  = vm->stk;
+	vm->rp  = vm->rstk;
+	*(vm->rstk) = ((pro->img) + TEXT_BASE);
+	vm->tdx = pro->img;
+	vm->lp_cont  = pro->img;
+	vm->lp_stop  = pro->img;
+	vm->lp_count = 0;
+	vm->c1 = vm->c2 = vm->c3 = vm->c4 = pro->img;
+	memset(vm->aio, 0, sizeof(vm->aio));
+}
 
-	// Allocate our to-be returned process object.
-	Process* pro = malloc_process();
 
-	// Allocate memory to hold the first 8 bytes which will contain the total img size.
-	void* mc   = malloc(8);
-	u64*  size = (u64*) mc;
+int
+run_context(VMContext* vm, u8 mode)
+{
+	return interpret(vm, mode);
+}
 
-	// Attempt to open file.
-	FILE* tpx_file = fopen(path, "rb");
 
-	// Read 8 bytes from start of file into the size block then set file-ptr back to start.
-	fread(size, 1, 8, tpx_file);
-	rewind(tpx_file);
+int
+execute_process(Process* pro)
+{
+	VMContext* vm = new_context(pro);
+	int retval;
 
-	// Now we know the exact size of the file in question we can alloc an array accurately.
-	// This array will go directly into the process obj then we read whole file into it.
-	mc = malloc(*size);
-	pro->img = (u8*) mc;
+	if (!vm)
+		return VM_ERROR;
 
-	// Read file contents into pro->img then close file.
-	fread(pro->img, 1, *size, tpx_file);
-	fclose(tpx_file);
+	retval = interpret(vm, EXEC_RUN);
+	free_context(vm);
+	return retval;
+}
 
-	// Write in the remaining process object vars.
-	// Firstly getting start-byte address from metadata then
-	// using this to set the start_byte process object pointer.
-	up0 = (u64*) ((pro->img) + START_ADDR_OFFS); 
-	pro->start_byte = ((u8*) (((pro->img) + (*up0))));
-	pro->size = *size;
-	
-	// Now the remaining metadata constants are written in.
-	// These are calculated from the constants below, hence the ptrs.
+
+// A worker finished its slice if it halted at the loop exit, not by dying or failing.
+static void*
+ploop_worker(void* arg)
+{
+	VMContext* vm = (VMContext*) arg;
+	u8* stop = vm->lp_stop;
+
+	if (interpret(vm, EXEC_RUN) != VM_DIED || vm->ip != stop)
+		return (void*) vm;
+	return 0;
+}
+
+
+/*
+	Run Parallel Loop:
+		Splits the count+1 iterations of a PLSTART loop into contiguous
+		chunks, one per worker context, each sharing the parent context's
+		process and native table. Worker 0 runs on the calling thread,
+		the rest get their own threads, falling back to running inline if a
+		thread can't be created. Once all have joined, the word left on top
+		of each worker's stack is summed into acc as the given type (U, I or
+		R), type N means the loop has no accumulator, and whatever output
+		the workers still have buffered is handed on in loop order.
+
+		Loops too short to be worth a thread each are given fewer workers,
+		never less than PLOOP_MIN_CHUNK iterations apiece, and so are
+		loops for which not every worker context can be had.
+
+		Returns FALSE, leaving acc as it was, if no context could be had
+		or any worker died or failed before finishing its slice.
+*/
+static int
+run_ploop(VMContext* vm, u8* tdx, u8* start, u8* stop, u64 count, s64 stride, u64* acc, u64 type)
+{
+	VMContext* vms[PLOOP_MAX_WORKERS];
+	pthread_t  threads[PLOOP_MAX_WORKERS];
+	u8  spawned[PLOOP_MAX_WORKERS];
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	u64 iters = count + 1;
+	u64 workers, chunk, extra, first, len, i;
+	void* failed = 0;
+	void* res;
+	u64 usum = 0;
+	s64 isum = 0;
+	r64 rsum = 0;
+
+	workers = (cpus > 0) ? (u64) cpus : 1;
+	if (workers > PLOOP_MAX_WORKERS)
+		workers = PLOOP_MAX_WORKERS;
+	if (workers > iters / PLOOP_MIN_CHUNK)
+		workers = iters / PLOOP_MIN_CHUNK;
+	if (!workers)
+		workers = 1;
+
+	for (i=0; i < workers; ++i) {
+		vms[i] = new_context(vm->pro);
+		if (!vms[i])
+			break;
+	}
+	if (!i)
+		return FALSE;
+	workers = i;
+
+	// Workers write output where we do, anything we've buffered goes first.
+	out_flush(&vm->out);
+
+	// Workers start at the top of the loop body with their own table
+	// pointer and count, the accumulator zeroed on top of the stack.
+	chunk = iters / workers;
+	extra = iters % workers;
+	first = 0;
+	for (i=0; i < workers; ++i) {
+		len = chunk + ((i < extra) ? 1 : 0);
+		memcpy(vms[i]->natives, vm->natives, sizeof(vm->natives));
+		vms[i]->out.fd   = vm->out.fd;
+		vms[i]->out.func = vm->out.func;
+		vms[i]->out.data = vm->out.data;
+		vms[i]->slice    = TRUE;
+		vms[i]->ip       = start;
+		vms[i]->lp_cont  = start;
+		vms[i]->lp_stop  = stop;
+		vms[i]->lp_count = len - 1;
+		vms[i]->tdx      = tdx + ((s64) first * stride);
+		if (vm->prof)
+			vms[i]->prof = new_profile(vm->prof->flags);
+		*((u64*) vms[i]->sp) = 0;
+		first += len;
+	}
+
+	// The loop body's time is in the workers' profiles, merged below, not PLSTART's.
+	if (vm->prof)
+		prof_stop(vm->prof);
+
+	for (i=1; i < workers; ++i)
+		spawned[i] = (pthread_create(&threads[i], 0, ploop_worker, vms[i]) == 0);
+
+	failed = ploop_worker(vms[0]);
+
+	for (i=1; i < workers; ++i) {
+		res = 0;
+		if (spawned[i])
+			pthread_join(threads[i], &res);
+		else
+			res = ploop_worker(vms[i]);
+		if (res)
+			failed = res;
+	}
+
+	switch (failed ? N : type) {
+		case U:
+			for (i=0; i < workers; ++i)
+				usum += *((u64*) vms[i]->sp);
+			*acc += usum;
+			break;
+		case I:
+			for (i=0; i < workers; ++i)
+				isum += *((s64*) vms[i]->sp);
+			*((s64*) acc) += isum;
+			break;
+		case R:
+			for (i=0; i < workers; ++i)
+				rsum += *((r64*) vms[i]->sp);
+			*((r64*) acc) += rsum;
+			break;
+	}
+
+	// What's left in the workers' buffers is passed on in loop order.
+	for (i=0; i < workers; ++i) {
+		out_bytes(&vm->out, vms[i]->out.buf, vms[i]->out.len);
+		if (vms[i]->prof)
+			prof_merge(vm->prof, vms[i]->prof);
+		free_context(vms[i]);
+	}
+
+	return !failed;
+}
+
+
+Process*
+malloc_process()
+{
+	void* mc = malloc(sizeof(Process));
+	Process* pro;
+
+	if (mc) {
+		pro = (Process*) mc;
+	} else {
+		return 0;
+	}
+
+	pro->size = 0;
+	pro->start_byte = 0;
+	pro->img = 0;
+	pro->result = 0;
+	pro->debug = TRUE;
+	pro->exports = 0;
+	pro->export_size = 0;
+	pro->files = 0;
+	pro->img_span = 0;
+	pro->map_base = 0;
+	memset(pro->maps, 0, sizeof(pro->maps));
+	pro->path = 0;
+	pro->dbinfo = 0;
+	pro->dbinfo_read = FALSE;
+	pro->breaks = 0;
+
+	return pro;
+}
+
+
+void
+free_process(Process* pro)
+{
+	if (pro->files)
+		free_file_table(pro->files);
+	free(pro->exports);
+	free(pro->path);
+	free_debug_info(pro->dbinfo);
+	free(pro->breaks);
+	if (pro->img)
+		munmap(pro->img, pro->img_span);
+	free(pro);
+}
+
+
+TextImage*
+read_text_image(const char* path)
+{
+	TextImage* timg;
+	u8  meta[METADATA_SIZE];
+	u64 *size, *export_base, *export_size;
+	u64 end;
+
+	// Attempt to open file.
+	FILE* tpx_file = fopen(path, "rb");
+
+	if (!tpx_file)
+		return 0;
+
+	// Read the metadata first then set file-ptr back to start, it gives the
+	// total text image size and where the export table lies beyond it.
+	if (fread(meta, 1, METADATA_SIZE, tpx_file) != METADATA_SIZE) {
+		fclose(tpx_file);
+		return 0;
+	}
+	rewind(tpx_file);
+
+	size        = (u64*) (meta + TIMG_SIZE_OFFS);
+	export_base = (u64*) (meta + EXPORT_BASE_OFFS);
+	export_size = (u64*) (meta + EXPORT_SIZE_OFFS);
+	end = *size;
+	if ((*export_size) && ((*export_base) + (*export_size)) > end)
+		end = (*export_base) + (*export_size);
+
+	if (*size < METADATA_SIZE) {
+		fclose(tpx_file);
+		return 0;
+	}
+
+	// Read the whole text image in then close file, a file cut short is no image.
+	timg = (TextImage*) malloc(sizeof(TextImage));
+	if (!timg) {
+		fclose(tpx_file);
+		return 0;
+	}
+	timg->bytes = (u8*) malloc(end);
+	timg->size  = timg->bytes ? fread(timg->bytes, 1, end, tpx_file) : 0;
+	fclose(tpx_file);
+
+	if (timg->size != end) {
+		free_text_image(timg);
+		return 0;
+	}
+	return timg;
+}
+
+
+void
+free_text_image(TextImage* timg)
+{
+	free(timg->bytes);
+	free(timg);
+}
+
+
+/*
+	Reserve Image:
+		Reserves address space for an image of size bytes followed by the
+		map window, the image part made readable and writable and the
+		window left inaccessible until MAPF maps something into it. If the
+		window can't be had the image is reserved alone, MAPF then fails.
+*/
+static u8*
+reserve_image(Process* pro, u64 size)
+{
+	u64   page = (u64) sysconf(_SC_PAGESIZE);
+	u64   span = (size + page - 1) & ~(page - 1);
+	void* img;
+
+	img = mmap(0, span + MAP_WINDOW_SIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	pro->img_span = span + MAP_WINDOW_SIZE;
+	if (img == MAP_FAILED) {
+		img = mmap(0, span, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		pro->img_span = span;
+		if (img == MAP_FAILED)
+			return 0;
+	}
+
+	if (mprotect(img, span, PROT_READ | PROT_WRITE) < 0) {
+		munmap(img, pro->img_span);
+		return 0;
+	}
+
+	pro->map_base = span;
+	return (u8*) img;
+}
+
+
+/*
+	Check Text Image:
+		Whatever a text image's metadata says is checked against the bytes
+		actually there before any of it is copied or reserved, so a short
+		or corrupt image is refused rather than read past. The text and
+		pool must lie within it, the start address within the text, and
+		the whole process image must be a size that can be added up.
+*/
+static int
+check_text_image(TextImage* timg, u64 args_size)
+{
+	u64 text_size, pool_size, heap_size, start, room;
+
+	if (timg->size < METADATA_SIZE)
+		return FALSE;
+
+	text_size = *((u64*) ((timg->bytes) + TEXT_SIZE_OFFS));
+	pool_size = *((u64*) ((timg->bytes) + POOL_SIZE_OFFS));
+	heap_size = *((u64*) ((timg->bytes) + HEAP_SIZE_OFFS));
+	start     = *((u64*) ((timg->bytes) + START_ADDR_OFFS));
+
+	room = timg->size - METADATA_SIZE;
+	if (text_size > room || pool_size > (room - text_size))
+		return FALSE;
+	if (start < TEXT_BASE || start >= (TEXT_BASE + text_size))
+		return FALSE;
+
+	// Text and pool fit in the image, so this can't overflow but the heap can.
+	room = ~((u64) 0) - (METADATA_SIZE + text_size + pool_size);
+	return args_size <= room && heap_size <= (room - args_size);
+}
+
+
+/*
+	Spawn Process:
+		Allocates a process image big enough for the text image plus the
+		largest args image ARGS_BUFFER_SIZE allows, so that it can later be
+		reset for any other run without reallocating. The text is copied in
+		once here, everything else is laid out by reset_process.
+
+		Returns 0 if the text image doesn't hold what its metadata says
+		or there's no memory for the process.
+*/
+Process*
+spawn_process(TextImage* timg, ProcessArgs* pargs)
+{
+	Process* pro;
+	u64* text_size = (u64*) ((timg->bytes) + TEXT_SIZE_OFFS);
+	u64* pool_size = (u64*) ((timg->bytes) + POOL_SIZE_OFFS);
+	u64* heap_size = (u64*) ((timg->bytes) + HEAP_SIZE_OFFS);
+	u64  args_size = (pargs->argsz > ARGS_BUFFER_SIZE) ? pargs->argsz : ARGS_BUFFER_SIZE;
+
+	u64* export_base = (u64*) ((timg->bytes) + EXPORT_BASE_OFFS);
+	u64* export_size = (u64*) ((timg->bytes) + EXPORT_SIZE_OFFS);
+
+	if (!check_text_image(timg, args_size))
+		return 0;
+
+	pro = malloc_process();
+	if (!pro)
+		return 0;
+
+	pro->img = reserve_image(pro, METADATA_SIZE + (*text_size) + args_size + (*pool_size) + (*heap_size));
+	if (!pro->img) {
+		free_process(pro);
+		return 0;
+	}
+	pro->files = new_file_table();
+	memcpy(pro->img, timg->bytes, METADATA_SIZE + (*text_size));
+	reset_process(pro, timg, pargs);
+
+	// The export table stays with the process, ty_export looks labels up in it.
+	if ((*export_size) && (*export_base) <= timg->size && (*export_size) <= (timg->size - (*export_base))) {
+		pro->exports = (u8*) malloc(*export_size);
+		if (pro->exports) {
+			pro->export_size = *export_size;
+			memcpy(pro->exports, ((timg->bytes) + (*export_base)), (*export_size));
+		}
+	}
+
+	return pro;
+}
+
+
+/*
+	Reset Process:
+		Lays a process image out ready for a fresh run, metadata, then the
+		args image, pool and a zeroed heap following the text. The text
+		itself is left as it is, it was copied in by spawn_process.
+*/
+void
+reset_process(Process* pro, TextImage* timg, ProcessArgs* pargs)
+{
+	// Pointers used for writing metadata values.
+	u64 *up0, *up1, *up2, *up3;
+	u64 args_base, pool_base, heap_base;
+
+	// Metadata comes fresh from the text image, the last run may have altered it.
+	memcpy(pro->img, timg->bytes, METADATA_SIZE);
+
+	up0 = (u64*) ((pro->img) + START_ADDR_OFFS);
 	up1 = (u64*) ((pro->img) + TEXT_SIZE_OFFS);
 	up2 = (u64*) ((pro->img) + POOL_SIZE_OFFS);
 	up3 = (u64*) ((pro->img) + HEAP_SIZE_OFFS);
-	up4 = (u64*) ((pro->img) + ARGS_SIZE_OFFS);
-	
-	// Use the above ptrs and this func's args to write in remains.
+
+	args_base = METADATA_SIZE + (*up1);
+	pool_base = args_base + pargs->argsz;
+	heap_base = pool_base + (*up2);
+
+	pro->start_byte = ((pro->img) + (*up0));
+	pro->size = heap_base + (*up3);
+	pro->result = 0;
+
+	// Files left open or mapped by the last run are closed.
+	if (pro->files)
+		close_files(pro->files);
+	unmap_files(pro);
+
+	// Copy in args bytes, the pool behind them then clear the heap.
+	memcpy(((pro->img) + args_base), pargs->buf, pargs->argsz);
+	memcpy(((pro->img) + pool_base), ((timg->bytes) + args_base), (*up2));
+	memset(((pro->img) + heap_base), 0, (*up3));
+
+	// Now the remaining metadata constants are written in.
+	up0 = (u64*) ((pro->img) + ARGS_BASE_OFFS);
+	*up0 = args_base;
 	up0 = (u64*) ((pro->img) + POOL_BASE_OFFS);
-	*up0 = METADATA_SIZE + (*up1) + (*up4);
+	*up0 = pool_base;
 	up0 = (u64*) ((pro->img) + HEAP_BASE_OFFS);
-	*up0 = METADATA_SIZE + (*up1) + (*up4) + (*up2);
+	*up0 = heap_base;
 	up0 = (u64*) ((pro->img) + PIMG_SIZE_OFFS);
-	*up0 = METADATA_SIZE + (*up1) + (*up4) + (*up2) + (*up3);
+	*up0 = pro->size;
 	up0 = (u64*) ((pro->img) + ARGS_COUNT_OFFS);
 	*up0 = pargs->argc;
 	up0 = (u64*) ((pro->img) + ARGS_SIZE_OFFS);
 	*up0 = pargs->argsz;
-				
-	// Copy in args bytes.
-	up0 = (u64*) ((pro->img) + ARGS_BASE_OFFS);
-	bp = ((pro->img) + (*up0));
-	memcpy(bp, pargs->buf, pargs->argsz);
-	
-	// Process object is now ready.
-	free(pargs);
+
+	// High-water marks start over with the run.
+	memset(&pro->usage, 0, sizeof(Usage));
+	heap_reset(pro);
+}
+
+
+// Args stay the caller's, spawn_process copies them into the image.
+Process*
+build_process(const char* path, ProcessArgs* pargs)
+{
+	TextImage* timg = read_text_image(path);
+	Process* pro;
+
+	if (!timg)
+		return 0;
+
+	pro = spawn_process(timg, pargs);
+	free_text_image(timg);
+	if (pro)
+		pro->path = strdup(path);
 	return pro;
 }
 
+// Reads the process' debug info on first use, it's 0 if the image has none.
+DebugInfo*
+process_debug_info(Process* pro)
+{
+	if (!pro->dbinfo_read && pro->path)
+		pro->dbinfo = read_debug_info(pro->path);
+	pro->dbinfo_read = TRUE;
+	return pro->dbinfo;
+}
+
+
 u64
 write_process(Process* pro, const char* path)
 {
@@ -2729,34 +3036,583 @@ write_process(Process* pro, const char* path)
 }
 
 
-int ty_main(int argc, char *argv[])
+static ProcessArgs*
+new_args(int argc, char** argv)
 {
 	ProcessArgs* pargs = (ProcessArgs*) malloc(sizeof(ProcessArgs));
-	pargs->buf = (u8*) malloc(ARGS_BUFFER_SIZE);
-	pargs->argc = argc - 1;
-	pargs->argsz = 0;
-	u8* bp = pargs->buf;
-	Process* pro;
-	u64 i;
+	u8* bp;
+	int i;
 
-	// writes in each arg adjusting arg_size as it goes.
-	for (i=1; i < argc; ++i) {
+	if (!pargs)
+		return 0;
+
+	pargs->argc  = argc;
+	pargs->argsz = 0;
+	for (i=0; i < argc; ++i)
 		(pargs->argsz) += (strlen(argv[i]) + 1);
+
+	// writes in each arg, 0-terminated and back to back.
+	pargs->buf = (u8*) malloc(pargs->argsz + 1);
+	if (!pargs->buf) {
+		free(pargs);
+		return 0;
+	}
+	bp = pargs->buf;
+	for (i=0; i < argc; ++i) {
 		strcpy(bp, argv[i]);
 		bp += (strlen(argv[i]) + 1);
 	}
-	
-	// Realloc args image so it fits snug.
-	pargs->buf = (u8*) realloc(pargs->buf, pargs->argsz);
-	
-	// pass all the arg info gained above to build_process to make the process image.
-	pro = build_process(argv[1], pargs);
-	
-	// ready for execution.
-	return execute_process(pro);
+
+	return pargs;
+}
+
+
+static void
+free_args(ProcessArgs* pargs)
+{
+	if (!pargs)
+		return;
+	free(pargs->buf);
+	free(pargs);
 }
 
+
+static int
+adopt_process(VMContext* vm, Process* pro)
+{
+	if (!pro)
+		return TY_ERROR;
+
+	if (vm->owner)
+		free_process(vm->owner);
+
+	pro->debug = FALSE;
+	vm->owner = pro;
+	bind_context(vm, pro);
+	return TY_OK;
+}
+
+
+VMContext*
+ty_create(void)
+{
+	return new_context(0);
+}
+
+
+void
+ty_destroy(VMContext* vm)
+{
+	free_context(vm);
+}
+
+
+int
+ty_load_path(VMContext* vm, const char* path, int argc, char** argv)
+{
+	ProcessArgs* pargs = new_args(argc, argv);
+	Process* pro = pargs ? build_process(path, pargs) : 0;
+
+	free_args(pargs);
+	return adopt_process(vm, pro);
+}
+
+
+/*
+	Load From Memory:
+		As ty_load_path but the text image is given as bytes, which are
+		copied so the caller is free to release them once this returns.
+*/
+int
+ty_load_mem(VMContext* vm, const uint8_t* bytes, uint64_t size, int argc, char** argv)
+{
+	TextImage timg;
+	ProcessArgs* pargs;
+	Process* pro;
+
+	if (!bytes || size < METADATA_SIZE || *((u64*) bytes) > size)
+		return TY_ERROR;
+
+	timg.size  = size;
+	timg.bytes = (u8*) bytes;
+	pargs = new_args(argc, argv);
+	pro = pargs ? spawn_process(&timg, pargs) : 0;
+	free_args(pargs);
+
+	return adopt_process(vm, pro);
+}
+
+
+int
+ty_run(VMContext* vm)
+{
+	if (!vm->pro)
+		return TY_ERROR;
+	return interpret(vm, EXEC_RUN);
+}
+
+
+int
+ty_step(VMContext* vm)
+{
+	if (!vm->pro)
+		return TY_ERROR;
+	return interpret(vm, EXEC_STEP);
+}
+
+
+void
+ty_registers(VMContext* vm, VMRegisters* regs)
+{
+	u8* img = vm->pro ? vm->pro->img : 0;
+
+	regs->ip       = (u64) (vm->ip - img);
+	regs->sp       = (u64) (vm->sp - vm->stk);
+	regs->rp       = (u64) (vm->rp - vm->rstk);
+	regs->tdx      = (u64) (vm->tdx - img);
+	regs->lp_cont  = (u64) (vm->lp_cont - img);
+	regs->lp_stop  = (u64) (vm->lp_stop - img);
+	regs->lp_count = vm->lp_count;
+	regs->top      = *((u64*) vm->sp);
+}
+
+
+void
+ty_usage(VMContext* vm, VMUsage* usage)
+{
+	Process* pro = vm->pro;
+
+	memset(usage, 0, sizeof(VMUsage));
+	usage->stack_size  = STACK_SIZE;
+	usage->rstack_size = RECUR_LIMIT;
+	if (!pro)
+		return;
+
+	usage->stack_peak     = pro->usage.stk_peak;
+	usage->rstack_peak    = pro->usage.rstk_peak;
+	usage->heap_allocs    = pro->usage.heap_allocs;
+	usage->heap_allocated = pro->usage.heap_bytes;
+	usage->heap_live      = pro->usage.heap_live;
+	usage->heap_peak      = pro->usage.heap_peak;
+	usage->heap_size      = *((u64*) ((pro->img) + HEAP_SIZE_OFFS));
+	usage->stack_approx   = pro->usage.approx;
+}
+
+
+// Runs the context on the depth table, or not, so its stack peaks are exact.
+void
+ty_track_depth(VMContext* vm, int on)
+{
+	vm->depth = on ? TRUE : FALSE;
+}
+
+
+// One line of what a run used against its bounds, for tyson -u and the batch summary.
+void
+print_usage(FILE* f, const VMUsage* usage)
+{
+	fprintf(f, "\n\tusage: stack %s%llu/%llu bytes, return stack %llu/%llu, heap %llu/%llu bytes peak"
+	        " in %llu allocs of %llu bytes\n", usage->stack_approx ? "at least " : "",
+	        (unsigned long long) usage->stack_peak, (unsigned long long) usage->stack_size,
+	        (unsigned long long) usage->rstack_peak, (unsigned long long) usage->rstack_size,
+	        (unsigned long long) usage->heap_peak, (unsigned long long) usage->heap_size,
+	        (unsigned long long) usage->heap_allocs, (unsigned long long) usage->heap_allocated);
+}
+
+
+// Returns the context's process image, writing its size to size if given.
+uint8_t*
+ty_image(VMContext* vm, uint64_t* size)
+{
+	if (!vm->pro)
+		return 0;
+	if (size)
+		*size = vm->pro->size;
+	return vm->pro->img;
+}
+
+
+/*
+	Lookup Export:
+		Returns the text address of the exported label name, or -1 if the
+		loaded image doesn't export it. Export tables hold a u64 entry
+		count then, for each entry, the label's u64 address followed by
+		its 0-terminated name.
+
+	Usage:
+		Look an export up once and keep the address for ty_call.
+*/
+int64_t
+ty_export(VMContext* vm, const char* name)
+{
+	u8 *bp, *end;
+	u64 *up, count;
+
+	if (!vm->pro || vm->pro->export_size < wordsize)
+		return -1;
+
+	bp  = vm->pro->exports;
+	end = bp + vm->pro->export_size;
+	up  = (u64*) bp;
+	count = *up;
+	bp += wordsize;
+
+	while (count-- && (bp + wordsize) < end) {
+		up  = (u64*) bp;
+		bp += wordsize;
+		if (strcmp((char*) bp, name) == 0)
+			return (int64_t) *up;
+		bp += strlen((char*) bp) + 1;
+	}
+
+	return -1;
+}
+
+
+/*
+	Call Export:
+		Calls the subroutine at addr as a CALL would, with argc args
+		pushed onto an emptied work stack, the last on top. Its return
+		address is the context's callret DIE, so when the matching RET
+		empties the return stack the interpreter halts and the word then
+		on top of the stack is written to result.
+
+		The heap, table pointer and loop registers carry over between
+		calls, so an image can be run once to initialise and then called
+		into any number of times.
+
+		Returns TY_RETURNED, or TY_DIED if the process died before
+		returning, or TY_ERROR if there's no process or no room for args.
+*/
+int
+ty_call(VMContext* vm, uint64_t addr, const uint64_t* args, uint64_t argc, uint64_t* result)
+{
+	u64 i;
+
+	if (!vm->pro || addr >= vm->pro->size || argc >= (STACK_SIZE / wordsize))
+		return TY_ERROR;
+
+	vm->sp = vm->stk;
+	for (i=0; i < argc; ++i) {
+		vm->sp += wordsize;
+		memcpy(vm->sp, &args[i], wordsize);
+	}
+
+	vm->rp = vm->rstk + 1;
+	*(vm->rp) = vm->callret;
+	vm->ip = ((vm->pro->img) + addr);
+
+	interpret(vm, EXEC_RUN);
+
+	if (result)
+		memcpy(result, vm->sp, wordsize);
+	return (vm->ip == vm->callret) ? TY_RETURNED : TY_DIED;
+}
+
+
+/*
+	Register Native:
+		Puts func in slot index of the context's native table, replacing
+		whatever was there, builtins included. NCALL index then calls it
+		with data passed through untouched.
+*/
+int
+ty_register_native(VMContext* vm, uint64_t index, VMNativeFunc func, void* data)
+{
+	if (index >= NATIVE_TABLE_SIZE)
+		return TY_ERROR;
+
+	vm->natives[index].func = func;
+	vm->natives[index].data = data;
+	return TY_OK;
+}
+
+
+// Sends the context's output to fd, which the host keeps open until it's done.
+void
+ty_output_fd(VMContext* vm, int fd)
+{
+	out_flush(&vm->out);
+	vm->out.fd   = fd;
+	vm->out.func = 0;
+	vm->out.data = 0;
+}
+
+
+// Sends the context's output to func instead, or back to its descriptor if 0.
+void
+ty_output_func(VMContext* vm, VMOutputFunc func, void* data)
+{
+	out_flush(&vm->out);
+	vm->out.func = func;
+	vm->out.data = data;
+}
+
+
+void
+ty_flush(VMContext* vm)
+{
+	out_flush(&vm->out);
+}
+
+
+/*
+	Profile:
+		Starts counting the context's instructions by opcode, with clock
+		cycles too if cycles is set, or stops and drops the counts if
+		flags is TY_PROF_OFF. Counts carry on across runs until then.
+		TY_PROF_PERF adds native instructions, branch and cache misses
+		per opcode and fails if the machine won't count any of them.
+*/
+int
+ty_profile(VMContext* vm, int flags)
+{
+	free_profile(vm->prof);
+	vm->prof = 0;
+	if (flags == TY_PROF_OFF)
+		return TY_OK;
+
+	if (flags & TY_PROF_PERF)
+		vm->prof = new_profile(PROF_CYCLES | PROF_PERF);
+	else
+		vm->prof = new_profile((flags & TY_PROF_CYCLES) ? PROF_CYCLES : 0);
+	if (!vm->prof)
+		return TY_ERROR;
+
+	// Opened here as well as by prof_start, to know now if there are any to be had.
+	if ((flags & TY_PROF_PERF) && !perf_open(&vm->prof->perf)) {
+		free_profile(vm->prof);
+		vm->prof = 0;
+		return TY_ERROR;
+	}
+	return TY_OK;
+}
+
+
+// Writes the profile table to the context's output, if it has one.
+void
+ty_profile_dump(VMContext* vm)
+{
+	if (vm->prof) {
+		prof_dump(vm->prof, &vm->out);
+		out_flush(&vm->out);
+	}
+}
+
+
+/*
+	Sample:
+		Starts sampling the context's ip and call stack hz times a second
+		of cpu time it spends running, or stops and drops the samples if
+		hz is 0. ty_sample_write saves them for typrof.py and
+		ty_sample_write_folded as collapsed stacks for flame graphs.
+*/
+int
+ty_sample(VMContext* vm, uint64_t hz)
+{
+	free_sampler(vm->samp);
+	vm->samp = 0;
+	if (!hz)
+		return TY_OK;
+
+	vm->samp = new_sampler(hz);
+	return vm->samp ? TY_OK : TY_ERROR;
+}
+
+
+int
+ty_sample_write(VMContext* vm, const char* path)
+{
+	if (!vm->samp || sampler_write(vm->samp, path) < 0)
+		return TY_ERROR;
+	return TY_OK;
+}
+
+
+int
+ty_sample_write_folded(VMContext* vm, const char* path)
+{
+	if (!vm->samp || !vm->pro || sampler_write_folded(vm->samp, vm->pro, path) < 0)
+		return TY_ERROR;
+	return TY_OK;
+}
+
+
+/*
+	Trace:
+		Starts recording every instruction the context runs into a ring
+		of about size bytes, the oldest records giving way once it fills,
+		or stops and drops the trace if size is 0. ty_trace_write saves
+		it for tytrace.py.
+*/
+int
+ty_trace(VMContext* vm, uint64_t size)
+{
+	free_tracer(vm->trace);
+	vm->trace = 0;
+	if (!size)
+		return TY_OK;
+
+	vm->trace = new_tracer(size);
+	return vm->trace ? TY_OK : TY_ERROR;
+}
+
+
+int
+ty_trace_write(VMContext* vm, const char* path)
+{
+	if (!vm->trace || trace_write(vm->trace, path) < 0)
+		return TY_ERROR;
+	return TY_OK;
+}
+
+
+/*
+	Main:
+		tyson [-p|-P|-H] [-u] [-s samplefile] [-f foldedfile] [-t tracefile] [-o outfile] <image.tpx> [args...]
+		tyson -b <image.tpx> [argfile]
+
+		-o sends everything the process shows to outfile instead of stdout.
+		-p counts instructions by opcode and -P times them as well, the
+		table going to stderr once the process dies. -H adds hardware
+		counters to -P's table.
+		-u runs on the depth table and writes how deep the stacks went
+		and how much heap was used to stderr once the process dies, see
+		ty_usage.
+		-s samples ip and the call stack into samplefile, see typrof.py.
+		-f samples the same way but writes collapsed stacks, named by the
+		image's labels when it was assembled with -g, for flamegraph.pl.
+		-t records every instruction into tracefile, see tytrace.py, the
+		last TRACE_DEFAULT_SIZE bytes of it if the run is a long one.
+*/
+int ty_main(int argc, char *argv[])
+{
+	Process*   pro;
+	ProcessArgs* pargs;
+	VMContext* vm;
+	const char* samples = 0;
+	const char* folded  = 0;
+	const char* trace   = 0;
+	int out = -1, prof = TY_PROF_OFF, usage = FALSE, retval;
+	VMUsage used;
+
+	// tyson -b runs one image over many arg sets, see batch_main.
+	if (argc > 1 && strcmp(argv[1], "-b") == 0)
+		return batch_main(argc, argv);
+
+	if (argc > 1 && (strcmp(argv[1], "-p") == 0 || strcmp(argv[1], "-P") == 0 || strcmp(argv[1], "-H") == 0)) {
+		prof = (argv[1][1] == 'H') ? TY_PROF_PERF :
+		       (argv[1][1] == 'P') ? TY_PROF_CYCLES : TY_PROF_COUNTS;
+		--argc;
+		++argv;
+	}
+
+	if (argc > 1 && strcmp(argv[1], "-u") == 0) {
+		usage = TRUE;
+		--argc;
+		++argv;
+	}
+
+	if (argc > 2 && strcmp(argv[1], "-s") == 0) {
+		samples = argv[2];
+		argc -= 2;
+		argv += 2;
+	}
+
+	if (argc > 2 && strcmp(argv[1], "-f") == 0) {
+		folded = argv[2];
+		argc -= 2;
+		argv += 2;
+	}
+
+	if (argc > 2 && strcmp(argv[1], "-t") == 0) {
+		trace = argv[2];
+		argc -= 2;
+		argv += 2;
+	}
+
+	if (argc > 2 && strcmp(argv[1], "-o") == 0) {
+		out = open(argv[2], O_WRONLY | O_CREAT | O_TRUNC, 0666);
+		if (out < 0) {
+			printf("\n\tfailed to open \"%s\".", argv[2]);
+			return 1;
+		}
+		argc -= 2;
+		argv += 2;
+	}
+
+	if (argc < 2) {
+		printf("\n\tinvalid input to tyson.");
+		if (out >= 0)
+			close(out);
+		return 1;
+	}
+
+	// pass all args but our own name to build_process to make the process image.
+	pargs = new_args(argc - 1, argv + 1);
+	pro = pargs ? build_process(argv[1], pargs) : 0;
+	free_args(pargs);
+	if (!pro) {
+		printf("\n\tfailed to open \"%s\".", argv[1]);
+		if (out >= 0)
+			close(out);
+		return 1;
+	}
+	
+	// ready for execution, the context owns the process from here on.
+	vm = new_context(pro);
+	if (!vm) {
+		printf("\n\tout of memory.");
+		free_process(pro);
+		if (out >= 0)
+			close(out);
+		return 1;
+	}
+	vm->owner = pro;
+	if (out >= 0)
+		ty_output_fd(vm, out);
+	if (ty_profile(vm, prof) != TY_OK) {
+		printf("\n\tfailed to start the profiler%s.", (prof == TY_PROF_PERF) ? ", no hardware counters" : "");
+		goto fail;
+	}
+	if ((samples || folded) && ty_sample(vm, SAMPLE_DEFAULT_HZ) != TY_OK) {
+		printf("\n\tfailed to start the sampler.");
+		goto fail;
+	}
+	if (trace && ty_trace(vm, TRACE_DEFAULT_SIZE) != TY_OK) {
+		printf("\n\tfailed to start the tracer.");
+		goto fail;
+	}
+	ty_track_depth(vm, usage);
+
+	retval = run_context(vm, EXEC_RUN);
+	if (samples && ty_sample_write(vm, samples) != TY_OK)
+		printf("\n\tfailed to write samples to \"%s\".", samples);
+	if (folded && ty_sample_write_folded(vm, folded) != TY_OK)
+		printf("\n\tfailed to write samples to \"%s\".", folded);
+	if (trace && ty_trace_write(vm, trace) != TY_OK)
+		printf("\n\tfailed to write the trace to \"%s\".", trace);
+	if (vm->prof) {
+		ty_output_fd(vm, 2);
+		ty_profile_dump(vm);
+	}
+	if (usage) {
+		ty_usage(vm, &used);
+		print_usage(stderr, &used);
+	}
+	free_context(vm);
+	if (out >= 0)
+		close(out);
+	return retval;
+
+fail:
+	free_context(vm);
+	if (out >= 0)
+		close(out);
+	return 1;
+}
+#ifndef TYSON_LIB
 int main(int argc, char *argv[]) {
 	return ty_main(argc, argv);
 }
-
+#endif
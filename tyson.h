@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <stdint.h>
 
+#include "libtyson.h"
 
 #define STACK_BYTES_RESERVED 100
 
@@ -35,7 +36,7 @@
 
 
 // Important Constants.
-#define METADATA_SIZE     (96)
+#define METADATA_SIZE     (128)
 #define START_MARKER      ("main") 
 #define STACK_SIZE        (120000)
 #define RECUR_LIMIT       (200)
@@ -44,6 +45,10 @@
 #define GCOL_THRESHOLD    (2400)
 #define TEXT_BASE         (METADATA_SIZE)
 #define ARGS_BUFFER_SIZE  (5000)
+#define PLOOP_MAX_WORKERS (64)
+#define PLOOP_MIN_CHUNK   (256)
+#define MAP_WINDOW_SIZE   ((u64) 1 << 36) // address space kept after each image for MAPF.
+#define MAP_TABLE_SIZE    (64)
 
 #define TIMG_SIZE_OFFS	  (0)
 #define START_ADDR_OFFS   (8)
@@ -57,6 +62,10 @@
 #define HEAP_SIZE_OFFS    (72)
 #define ARGS_COUNT_OFFS   (80)
 #define ARGS_SIZE_OFFS    (88)
+#define EXPORT_BASE_OFFS  (96)
+#define EXPORT_SIZE_OFFS  (104)
+#define DEBUG_BASE_OFFS   (112)
+#define DEBUG_SIZE_OFFS   (120)
 
 // Native Datatype Declarations.
 /*
@@ -83,6 +92,7 @@
 */
 
 typedef uint8_t      u8;
+typedef uint32_t    u32;
 typedef uint64_t    u64;
 typedef int64_t     s64;
 typedef double      r64;
@@ -98,25 +108,214 @@ struct Word {
 	u8 byte5;
 	u8 byte6;
 	u8 byte7;
-} __packed__;
+} __attribute__((packed));
 
+// Per-process descriptor table, see fileio.h.
+typedef struct FileTable FileTable;
+
+// A file MAPF has mapped into the map window.
+typedef struct {
+	u64 offs;
+	u64 size;
+} MapRegion;
+
+// Allocator state, see heap.h.
+#define HEAP_CLASSES (48)
+
+typedef struct {
+	u64 base;
+	u64 top;
+	u64 free[HEAP_CLASSES];
+} HeapState;
+
+/*
+	Usage:
+		High-water marks of a process' run, started over by reset_process.
+
+		stk_peak and rstk_peak are how deep sp and rp went, bytes above
+		stk and return addresses above rstk. Comparing them on every
+		dispatch would cost every instruction, so a plain run only
+		compares them at each CALL and whenever it halts, and pushes
+		popped again before the next CALL can go unseen. A context with
+		depth set runs on the depth table, which compares them on every
+		dispatch, as do the instrumented tables (-p, -s or -t). approx is
+		set once any part of a run wasn't, stk_peak is then only a lower
+		bound. rstk_peak is always exact, only CALL and RSTK_UP raise rp.
+
+		The heap counts are exact, whole blocks header included, but only
+		cover what the allocator hands out, not the fixed addresses
+		programs write to themselves.
+*/
+typedef struct {
+	u64 stk_peak;
+	u64 rstk_peak;
+	u64 heap_allocs;
+	u64 heap_bytes; // handed out, ever.
+	u64 heap_live;
+	u64 heap_peak;  // most live at once.
+	u8  approx;
+} Usage;
+
+// Labels, source lines and symbols from tyasm.py -g, see dbinfo.h.
+typedef struct DebugInfo DebugInfo;
+
+// Patched in by the interactive debugger, see debug.h.
+typedef struct Breakpoints Breakpoints;
+
+/*
+	Process:
+		img is the start of a reservation of img_span bytes of address
+		space. The image proper takes the first map_base bytes and the rest
+		is the map window, where MAPF maps files so that they can be
+		addressed img-relative like the rest of the image.
+
+		path is the image file a process was built from, 0 when it came
+		from memory, and its debug info is only read from there the first
+		time process_debug_info is called.
+*/
 typedef struct {
 	u64 size;
 	u8* start_byte;
 	u8* img;
+	u64 result; // word on top of the work stack when the process died.
+	u8  debug;  // DEBUG_MODE only, start in the interactive debugger.
+	u8* exports;
+	u64 export_size;
+	FileTable* files;
+	u64 img_span;
+	u64 map_base;
+	MapRegion maps[MAP_TABLE_SIZE];
+	HeapState heap;
+	Usage usage;
+	char* path;
+	DebugInfo* dbinfo;
+	u8  dbinfo_read; // TRUE once dbinfo has been looked for.
+	Breakpoints* breaks;
 } Process;
 
+/*
+	Text Image:
+		A .tpx file as read from disk, metadata, text and pool, followed by
+		the export table if the image has one. It is never executed itself,
+		processes are laid out from it by spawn_process and can be re-laid
+		for another run with reset_process, which leaves the already copied
+		text alone.
+*/
+typedef struct {
+	u64 size;
+	u8* bytes;
+} TextImage;
+
 typedef struct {
 	u64 argc;
 	u64 argsz;
 	u8* buf;
 } ProcessArgs;
 
+#define NATIVE_TABLE_SIZE (256)
+
+typedef struct {
+	VMNativeFunc func;
+	void*        data;
+} Native;
+
+// Async request tickets per context, see aio.h.
+#define AIO_SLOTS (64)
+
+#define AIO_FREE     0
+#define AIO_PENDING  1
+#define AIO_DONE     2
+
+typedef struct AsyncRing AsyncRing;
+
+// Bytes of SHOW_* and trace output a context gathers before writing, see output.h.
+#define OUTPUT_BUFFER_SIZE (1 << 16)
+
+typedef struct {
+	u64          len;
+	int          fd;   // where output goes, unless func is set.
+	VMOutputFunc func;
+	void*        data;
+	u8           buf[OUTPUT_BUFFER_SIZE];
+} OutBuf;
+
+typedef struct {
+	u8  state;
+	s64 result; // bytes transferred or -1, once done.
+} AsyncReq;
+
+// Per-opcode counters a context may carry, see profile.h.
+typedef struct Profile Profile;
+
+// Timer-driven ip and call stack samples a context may take, see sample.h.
+typedef struct Sampler Sampler;
+
+// Binary record of every instruction a context runs, see trace.h.
+typedef struct Tracer Tracer;
+
 #define hwordsize  4
 #define wordsize   8
 #define dwordsize 16
 #define qwordsize 32
 
+/*
+	VM Context:
+		Everything one running VM needs, its registers, stacks and scratch
+		buffer, with nothing kept in globals so any number of contexts can
+		run side by side. The interpreter keeps the registers in locals
+		while it runs and saves them back here whenever it halts.
+
+		A context runs whichever process it was last bound to. owner is set
+		when the context built that process itself and must free it.
+		slice marks PLSTART worker contexts, which halt at the loop exit.
+		callret holds a DIE, it is the return address ty_call gives the
+		exported subroutine so that its final RET halts the interpreter.
+		natives is the table NCALL indexes, builtins unless the host has
+		registered its own.
+		aio holds the tickets of async requests made on ring, which is
+		the context's own unless a scheduler has handed it a shared one.
+		parkable contexts halt at an AWAIT that would block rather than
+		waiting, leaving the scheduler to run something else.
+		out buffers everything the running process shows.
+*/
+struct VMContext {
+	Process* pro;
+	Process* owner;
+	u8*  ip;
+	u8*  sp;
+	u8** rp;
+	u8*  tdx;
+	u8*  lp_cont;
+	u8*  lp_stop;
+	u64  lp_count;
+	u8  *c1, *c2, *c3, *c4;
+	u8   slice;
+	u8   callret[wordsize];
+	Native natives[NATIVE_TABLE_SIZE];
+	AsyncRing* ring;
+	u8   own_ring;
+	u8   parkable;
+	AsyncReq aio[AIO_SLOTS];
+	OutBuf   out;
+	Profile* prof;
+	Sampler* samp;
+	Tracer*  trace;
+	u8   depth; // run on the depth table, see Usage.
+	u8*  rstk[RECUR_LIMIT];
+	u8   stk[STACK_SIZE];
+	u8   dbuf[DATABUF_SIZE];
+};
+
+// Interpreter modes.
+#define EXEC_RUN  0
+#define EXEC_STEP 1
+
+// Interpreter results.
+#define VM_DIED     TY_DIED
+#define VM_STEPPED  TY_STEPPED
+#define VM_ERROR    TY_ERROR
+#define VM_PARKED   (3) // parkable contexts only, never seen by library hosts.
+
 #define NIL 0
 #define WRD 10
 #define U8  11
@@ -143,5 +342,17 @@ Process* malloc_process();
 void     free_process(Process*);
 Process* build_process(const char*, ProcessArgs*);
 u64      write_process(Process*, const char*);
+void     print_usage(FILE*, const VMUsage*);
+DebugInfo* process_debug_info(Process*);
+
+TextImage* read_text_image(const char*);
+void       free_text_image(TextImage*);
+Process*   spawn_process(TextImage*, ProcessArgs*);
+void       reset_process(Process*, TextImage*, ProcessArgs*);
+
+VMContext* new_context(Process*);
+void       free_context(VMContext*);
+void       bind_context(VMContext*, Process*);
+int        run_context(VMContext*, u8);
 
 #endif
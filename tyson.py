@@ -22,6 +22,28 @@ fopen_codes = ( READ_MODE,
                 WRITE_UPDATE_MODE,
                 APPEND_UPDATE_MODE )
 
+# assembler symbols for openf's mode, seekf's whence and mapf's advice args.
+fopen_symbols = {'fmode_r'      : fopen_codemap[READ_MODE],
+                 'fmode_w'      : fopen_codemap[WRITE_MODE],
+                 'fmode_a'      : fopen_codemap[APPEND_MODE],
+                 'fmode_rp'     : fopen_codemap[READ_UPDATE_MODE],
+                 'fmode_wp'     : fopen_codemap[WRITE_UPDATE_MODE],
+                 'fmode_ap'     : fopen_codemap[APPEND_UPDATE_MODE],
+                 'seek_set'     : 0,
+                 'seek_cur'     : 1,
+                 'seek_end'     : 2,
+                 'map_normal'   : 0,
+                 'map_seq'      : 1,
+                 'map_random'   : 2,
+                 'map_willneed' : 3}
+
+# assembler symbols for the red_* instrs' type arg and hmap_new's key kind.
+type_symbols = {'type_u' : 12,
+                'type_i' : 13,
+                'type_r' : 14,
+                'hkey_u' : 0,
+                'hkey_s' : 1}
+
 U8  = 11
 U64 = 12
 S64 = 13
@@ -65,7 +87,7 @@ U64_MAX = 4294967295
 S64_MAX = 2147483647
 R64_MAX = 1.7976931348623157e+308
 
-OPCOUNT      = 213
+OPCOUNT      = 241
 
 DIE          =   0
 NOP          =   1
@@ -253,19 +275,19 @@ STK_POP      = 182
 STK_XCHT     = 183
 STK_GCOL     = 184
 OPENF        = 185
-RSV_SYS2     = 186
-RSV_SYS3     = 187
-RSV_SYS4     = 188
-RSV_SYS5     = 189
-RSV_SYS6     = 190
-RSV_SYS7     = 191
-RSV_SYS8     = 192
-RSV_SYS9     = 193
-RSV_SYS10    = 194
-RSV_SYS11    = 195
-RSV_SYS12    = 196
-RSV_SYS13    = 197
-RSV_SYS14    = 198
+NCALL        = 186
+CLOSEF       = 187
+READF        = 188
+WRITEF       = 189
+SEEKF        = 190
+READH        = 191
+WRITEH       = 192
+AREADH       = 193
+AWRITEH      = 194
+AWAIT        = 195
+MAPF         = 196
+UNMAPF       = 197
+FLUSH        = 198
 RSV_SYS15    = 199
 SHOW_TOP_B   = 200
 SHOW_TOP_U   = 201
@@ -280,10 +302,81 @@ TDX_B_UP     = 209
 TDX_B_DWN    = 210
 TDX_W_UP     = 211
 TDX_W_DWN    = 212
-
-
-METADATA_SIZE = 96
-TEXT_BASE     = 96
+PLSTART      = 213
+LS_NEW       = 214
+LS_FROM      = 215
+LS_TOC       = 216
+LS_LEN       = 217
+LS_CAT       = 218
+LS_CMP       = 219
+JMP_LS_EQ    = 220
+LS_SUB       = 221
+LS_FREE      = 222
+RED_SUM      = 223
+RED_MIN      = 224
+RED_MAX      = 225
+RED_DOT      = 226
+T_FD_CPYNW   = 227
+T_FD_FILLNW  = 228
+T_CMPNW      = 229
+T_DIFFNW     = 230
+HMAP_NEW     = 231
+HMAP_PUT     = 232
+HMAP_GET     = 233
+HMAP_DEL     = 234
+HMAP_ITER    = 235
+HMAP_LEN     = 236
+HMAP_FREE    = 237
+SORT         = 238
+SORT_KV      = 239
+PROF_DUMP    = 240
+
+NAT_SQRT     =   0
+NAT_POW      =   1
+NAT_EXP      =   2
+NAT_LOG      =   3
+NAT_SIN      =   4
+NAT_COS      =   5
+NAT_FLOOR    =   6
+NAT_CEIL     =   7
+NAT_FABS     =   8
+NAT_HASH_S   =   9
+NAT_HASH_T   =  10
+NAT_HASH_U   =  11
+NAT_STR2U    =  12
+NAT_STR2I    =  13
+NAT_STR2R    =  14
+
+native_map = {'nat_sqrt'   : NAT_SQRT,
+              'nat_pow'    : NAT_POW,
+              'nat_exp'    : NAT_EXP,
+              'nat_log'    : NAT_LOG,
+              'nat_sin'    : NAT_SIN,
+              'nat_cos'    : NAT_COS,
+              'nat_floor'  : NAT_FLOOR,
+              'nat_ceil'   : NAT_CEIL,
+              'nat_fabs'   : NAT_FABS,
+              'nat_hash_s' : NAT_HASH_S,
+              'nat_hash_t' : NAT_HASH_T,
+              'nat_hash_u' : NAT_HASH_U,
+              'nat_str2u'  : NAT_STR2U,
+              'nat_str2i'  : NAT_STR2I,
+              'nat_str2r'  : NAT_STR2R}
+
+METADATA_SIZE = 128
+TEXT_BASE     = 128
+
+# metadata words locating the debug info tyasm.py -g appends.
+DEBUG_BASE_OFFS = 112
+DEBUG_SIZE_OFFS = 120
+
+# debug info starts with these, dbinfo.c refuses any other version.
+DEBUG_MAGIC   = b'TYDB'
+DEBUG_VERSION = 1
+
+# tyson -t trace files start with these, see trace.h.
+TRACE_MAGIC   = b'TYTR'
+TRACE_VERSION = 1
 
 opmap = {'die' : DIE, 
          'nop' : NOP, 
@@ -471,19 +564,19 @@ opmap = {'die' : DIE,
          'stk_xcht' : STK_XCHT,
          'stk_gcol' : STK_GCOL,
          'openf' : OPENF,
-         'rsv_sys2' : RSV_SYS2,
-         'rsv_sys3' : RSV_SYS3,
-         'rsv_sys4' : RSV_SYS4,
-         'rsv_sys5' : RSV_SYS5,
-         'rsv_sys6' : RSV_SYS6,
-         'rsv_sys7' : RSV_SYS7,
-         'rsv_sys8' : RSV_SYS8,
-         'rsv_sys9' : RSV_SYS9,
-         'rsv_sys10' : RSV_SYS10,
-         'rsv_sys11' : RSV_SYS11,
-         'rsv_sys12' : RSV_SYS12,
-         'rsv_sys13' : RSV_SYS13,
-         'rsv_sys14' : RSV_SYS14,
+         'ncall' : NCALL,
+         'closef' : CLOSEF,
+         'readf' : READF,
+         'writef' : WRITEF,
+         'seekf' : SEEKF,
+         'readh' : READH,
+         'writeh' : WRITEH,
+         'areadh' : AREADH,
+         'awriteh' : AWRITEH,
+         'await' : AWAIT,
+         'mapf' : MAPF,
+         'unmapf' : UNMAPF,
+         'flush' : FLUSH,
          'rsv_sys15' : RSV_SYS15,
          'show_top_b' : SHOW_TOP_B,
          'show_top_u' : SHOW_TOP_U,
@@ -497,7 +590,35 @@ opmap = {'die' : DIE,
          'tdx_b_up' : TDX_B_UP,
          'tdx_b_dwn' : TDX_B_DWN,
          'tdx_w_up' : TDX_W_UP,
-         'tdx_w_dwn' : TDX_W_DWN}
+         'tdx_w_dwn' : TDX_W_DWN,
+         'plstart' : PLSTART,
+         'ls_new' : LS_NEW,
+         'ls_from' : LS_FROM,
+         'ls_toc' : LS_TOC,
+         'ls_len' : LS_LEN,
+         'ls_cat' : LS_CAT,
+         'ls_cmp' : LS_CMP,
+         'jmp_ls_eq' : JMP_LS_EQ,
+         'ls_sub' : LS_SUB,
+         'ls_free' : LS_FREE,
+         'red_sum' : RED_SUM,
+         'red_min' : RED_MIN,
+         'red_max' : RED_MAX,
+         'red_dot' : RED_DOT,
+         't_fd_cpynw' : T_FD_CPYNW,
+         't_fd_fillnw' : T_FD_FILLNW,
+         't_cmpnw' : T_CMPNW,
+         't_diffnw' : T_DIFFNW,
+         'hmap_new' : HMAP_NEW,
+         'hmap_put' : HMAP_PUT,
+         'hmap_get' : HMAP_GET,
+         'hmap_del' : HMAP_DEL,
+         'hmap_iter' : HMAP_ITER,
+         'hmap_len' : HMAP_LEN,
+         'hmap_free' : HMAP_FREE,
+         'sort' : SORT,
+         'sort_kv' : SORT_KV,
+         'prof_dump' : PROF_DUMP}
 
 no_arg_ops = ( BREAKPOINT,
                DIE,
@@ -587,8 +708,40 @@ no_arg_ops = ( BREAKPOINT,
                TDX_B_UP,
                TDX_B_DWN,
                TDX_W_UP,
-               TDX_W_DWN )
+               TDX_W_DWN,
+               AWAIT,
+               FLUSH,
+               PROF_DUMP )
  
+# unsigned LEB128 varints and zigzag for signed ones, as the debug info uses.
+def uleb(value):
+	string = bytearray()
+	while True:
+		byte = value & 0x7f
+		value >>= 7
+		if value:
+			string.append(byte | 0x80)
+		else:
+			string.append(byte)
+			return bytes(string)
+
+def sleb(value):
+	return uleb((value << 1) if value >= 0 else ((-value << 1) - 1))
+
+def read_uleb(data, i):
+	value = shift = 0
+	while True:
+		byte = data[i]
+		i += 1
+		value |= (byte & 0x7f) << shift
+		shift += 7
+		if not byte & 0x80:
+			return value, i
+
+def read_sleb(data, i):
+	value, i = read_uleb(data, i)
+	return (value >> 1) if not value & 1 else -((value + 1) >> 1), i
+
 def from_opname(opname):
 	return opmap[opname]
 
@@ -0,0 +1,139 @@
+import sys
+import struct
+from bisect import bisect_right
+from tyson import *
+from typrof import DebugInfo
+
+# tytrace.py <image.tpx> <tracefile> [-d] [-b blockfile]
+#   rebuilds the instruction stream tyson -t recorded and reports its basic blocks by
+#   how much of the run they took and its branches by how often they were taken.
+#   -d lists every instruction, -b writes "addr runs length label" per block.
+
+opnames = {code: name for name, code in opmap.items()}
+
+# the trace's dropped block count, then every record as (ip, sp, opcode), ip an img
+# offset and sp bytes above stk.
+def read_trace(path):
+	data = open(path, 'rb').read()
+	if data[:4] != TRACE_MAGIC or data[4] != TRACE_VERSION:
+		raise ValueError('{} is not a tyson trace.'.format(path))
+	block_size, blocks, dropped = struct.unpack_from('<QQQ', data, 5)
+	yield dropped
+	for k in range(blocks):
+		base = 29 + k * block_size
+		ip, sp, size, count = struct.unpack_from('<QqII', data, base)
+		i = base + 24
+		for _ in range(count):
+			opcode = data[i]
+			dip, i = read_sleb(data, i + 1)
+			dsp, i = read_sleb(data, i)
+			ip += dip
+			sp += dsp
+			yield ip, sp, opcode
+
+def where(info, addr):
+	k = bisect_right(info.label_addrs, addr) - 1 if info.labels else -1
+	if k < 0:
+		return '@{}'.format(addr)
+	base, name = info.labels[k]
+	return name if addr == base else '{}+{}'.format(name, addr - base)
+
+class Blocks:
+	def __init__(self, records, info):
+		self.runs  = {}  # ip: times run.
+		self.ops   = {}  # ip: opcode.
+		self.taken = {}  # ip: times it went anywhere but the next instruction.
+		self.fell  = {}  # ip: times it went on to the next one.
+		self.total = 0
+		first = last = None
+		moves = {}
+		for ip, sp, op in records:
+			self.runs[ip] = self.runs.get(ip, 0) + 1
+			self.ops[ip]  = op
+			if last is None:
+				first = ip
+			else:
+				moves[(last, ip)] = moves.get((last, ip), 0) + 1
+			last = ip
+			self.total += 1
+
+		# instruction starts, exact from the line table, else what ran.
+		self.starts = info.line_addrs if info.lines else sorted(self.runs)
+
+		# a block starts where the trace does, at any branch target and after any branch.
+		self.leaders = set([first])
+		for (a, b), n in moves.items():
+			if b == self.next_instr(a):
+				self.fell[a] = self.fell.get(a, 0) + n
+			else:
+				self.taken[a] = self.taken.get(a, 0) + n
+				self.leaders.add(b)
+				self.leaders.add(self.next_instr(a))
+		self.leaders &= set(self.runs)
+
+	def next_instr(self, addr):
+		k = bisect_right(self.starts, addr)
+		return self.starts[k] if k < len(self.starts) else None
+
+	# instructions from the leader up to the next leader or a branch that always goes.
+	def length(self, leader):
+		n, addr = 0, leader
+		while addr in self.runs:
+			n += 1
+			if addr in self.taken and addr not in self.fell:
+				break
+			addr = self.next_instr(addr)
+			if addr in self.leaders:
+				break
+		return n
+
+def report(image_path, trace_path, listing=False, block_path=None):
+	info = DebugInfo(image_path)
+	records = read_trace(trace_path)
+	dropped = next(records)
+
+	if listing:
+		records = list(records)
+		for ip, sp, op in records:
+			print('\t{:>8}  {:<14} sp {:<6} {}'.format(ip, opnames.get(op, '?'), sp, where(info, ip)))
+
+	blocks = Blocks(records, info)
+	if not blocks.total:
+		print('\n\tno records in {}.'.format(trace_path))
+		return
+	rows = [(blocks.runs[leader], blocks.length(leader), leader) for leader in blocks.leaders]
+	rows.sort(key=lambda row: -row[0] * row[1])
+	total = blocks.total
+
+	print('\n\t{} instructions, {} basic blocks{}.\n'.format(total, len(rows),
+	      ', {} blocks lost to the ring wrapping'.format(dropped) if dropped else ''))
+	print('\t{:>10} {:>6} {:>7}  {}'.format('runs', 'instrs', 'share%', 'block'))
+	for runs, length, leader in rows[:20]:
+		line = info.line(leader) if info.lines else 0
+		print('\t{:>10} {:>6} {:>7.2f}  {}{}'.format(runs, length, 100.0 * runs * length / total,
+		                                            where(info, leader), ' (line {})'.format(line) if line else ''))
+
+	print('\n\t{:>10} {:>10}  {}'.format('taken', 'not taken', 'branch'))
+	for addr in sorted(blocks.taken, key=lambda addr: -blocks.taken[addr])[:20]:
+		print('\t{:>10} {:>10}  {} at {}'.format(blocks.taken[addr], blocks.fell.get(addr, 0),
+		                                         opnames.get(blocks.ops[addr], '?'), where(info, addr)))
+
+	if block_path:
+		with open(block_path, 'w') as f:
+			for runs, length, leader in sorted(rows, key=lambda row: row[2]):
+				f.write('{} {} {} {}\n'.format(leader, runs, length, where(info, leader)))
+
+if __name__ == '__main__':
+	args = sys.argv[1:]
+	listing = '-d' in args
+	if listing:
+		args.remove('-d')
+	block_path = None
+	if '-b' in args and args.index('-b') + 1 < len(args):
+		k = args.index('-b')
+		block_path = args[k + 1]
+		del args[k:k + 2]
+	if len(args) == 2:
+		report(args[0], args[1], listing, block_path)
+	else:
+		print('\n\tinvalid input to tytrace.')